@@ -109,7 +109,7 @@ namespace Sass {
     ADD_PROPERTY(string, path);
     ADD_PROPERTY(Position, position);
   public:
-    AST_Node(string path, Position position) : path_(path), position_(position) { }
+    AST_Node(const string& path, Position position) : path_(path), position_(position) { }
     virtual ~AST_Node() = 0;
     // virtual Block* block() { return 0; }
     ATTACH_OPERATIONS();
@@ -123,7 +123,7 @@ namespace Sass {
   /////////////////////////////////////////////////////////////////////////
   class Statement : public AST_Node {
   public:
-    Statement(string path, Position position) : AST_Node(path, position) { }
+    Statement(const string& path, Position position) : AST_Node(path, position) { }
     virtual ~Statement() = 0;
     // needed for rearranging nested rulesets during CSS emission
     virtual bool   is_hoistable() { return false; }
@@ -146,7 +146,7 @@ namespace Sass {
       else                   has_non_hoistable_ = true;
     };
   public:
-    Block(string path, Position position, size_t s = 0, bool r = false)
+    Block(const string& path, Position position, size_t s = 0, bool r = false)
     : Statement(path, position),
       Vectorized<Statement*>(s),
       is_root_(r), has_hoistable_(false), has_non_hoistable_(false)
@@ -161,7 +161,7 @@ namespace Sass {
   class Has_Block : public Statement {
     ADD_PROPERTY(Block*, block);
   public:
-    Has_Block(string path, Position position, Block* b)
+    Has_Block(const string& path, Position position, Block* b)
     : Statement(path, position), block_(b)
     { }
     virtual ~Has_Block() = 0;
@@ -176,7 +176,7 @@ namespace Sass {
   class Ruleset : public Has_Block {
     ADD_PROPERTY(Selector*, selector);
   public:
-    Ruleset(string path, Position position, Selector* s, Block* b)
+    Ruleset(const string& path, Position position, Selector* s, Block* b)
     : Has_Block(path, position, b), selector_(s)
     { }
     // nested rulesets need to be hoisted out of their enclosing blocks
@@ -191,7 +191,7 @@ namespace Sass {
   class Propset : public Has_Block {
     ADD_PROPERTY(String*, property_fragment);
   public:
-    Propset(string path, Position position, String* pf, Block* b = 0)
+    Propset(const string& path, Position position, String* pf, Block* b = 0)
     : Has_Block(path, position, b), property_fragment_(pf)
     { }
     ATTACH_OPERATIONS();
@@ -205,7 +205,7 @@ namespace Sass {
     ADD_PROPERTY(List*, media_queries);
     ADD_PROPERTY(Selector*, enclosing_selector);
   public:
-    Media_Block(string path, Position position, List* mqs, Block* b)
+    Media_Block(const string& path, Position position, List* mqs, Block* b)
     : Has_Block(path, position, b), media_queries_(mqs), enclosing_selector_(0)
     { }
     bool is_hoistable() { return true; }
@@ -221,7 +221,7 @@ namespace Sass {
     ADD_PROPERTY(Selector*, selector);
     ADD_PROPERTY(Expression*, value);
   public:
-    At_Rule(string path, Position position, string kwd, Selector* sel = 0, Block* b = 0)
+    At_Rule(const string& path, Position position, string kwd, Selector* sel = 0, Block* b = 0)
     : Has_Block(path, position, b), keyword_(kwd), selector_(sel), value_(0) // set value manually if needed
     { }
     ATTACH_OPERATIONS();
@@ -235,7 +235,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, value);
     ADD_PROPERTY(bool, is_important);
   public:
-    Declaration(string path, Position position,
+    Declaration(const string& path, Position position,
                 String* prop, Expression* val, bool i = false)
     : Statement(path, position), property_(prop), value_(val), is_important_(i)
     { }
@@ -252,7 +252,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, value);
     ADD_PROPERTY(bool, is_guarded);
   public:
-    Assignment(string path, Position position,
+    Assignment(const string& path, Position position,
                string var, Expression* val, bool guarded = false)
     : Statement(path, position), variable_(var), value_(val), is_guarded_(guarded)
     { }
@@ -267,7 +267,7 @@ namespace Sass {
     vector<string>         files_;
     vector<Expression*> urls_;
   public:
-    Import(string path, Position position)
+    Import(const string& path, Position position)
     : Statement(path, position),
       files_(vector<string>()), urls_(vector<Expression*>())
     { }
@@ -279,7 +279,7 @@ namespace Sass {
   class Import_Stub : public Statement {
     ADD_PROPERTY(string, file_name);
   public:
-    Import_Stub(string path, Position position, string f)
+    Import_Stub(const string& path, Position position, string f)
     : Statement(path, position), file_name_(f)
     { }
     ATTACH_OPERATIONS();
@@ -291,7 +291,7 @@ namespace Sass {
   class Warning : public Statement {
     ADD_PROPERTY(Expression*, message);
   public:
-    Warning(string path, Position position, Expression* msg)
+    Warning(const string& path, Position position, Expression* msg)
     : Statement(path, position), message_(msg)
     { }
     ATTACH_OPERATIONS();
@@ -303,7 +303,7 @@ namespace Sass {
   class Comment : public Statement {
     ADD_PROPERTY(String*, text);
   public:
-    Comment(string path, Position position, String* txt)
+    Comment(const string& path, Position position, String* txt)
     : Statement(path, position), text_(txt)
     { }
     ATTACH_OPERATIONS();
@@ -317,7 +317,7 @@ namespace Sass {
     ADD_PROPERTY(Block*, consequent);
     ADD_PROPERTY(Block*, alternative);
   public:
-    If(string path, Position position, Expression* pred, Block* con, Block* alt = 0)
+    If(const string& path, Position position, Expression* pred, Block* con, Block* alt = 0)
     : Statement(path, position), predicate_(pred), consequent_(con), alternative_(alt)
     { }
     ATTACH_OPERATIONS();
@@ -332,7 +332,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, upper_bound);
     ADD_PROPERTY(bool, is_inclusive);
   public:
-    For(string path, Position position,
+    For(const string& path, Position position,
         string var, Expression* lo, Expression* hi, Block* b, bool inc)
     : Has_Block(path, position, b),
       variable_(var), lower_bound_(lo), upper_bound_(hi), is_inclusive_(inc)
@@ -347,7 +347,7 @@ namespace Sass {
     ADD_PROPERTY(string, variable);
     ADD_PROPERTY(Expression*, list);
   public:
-    Each(string path, Position position, string var, Expression* lst, Block* b)
+    Each(const string& path, Position position, string var, Expression* lst, Block* b)
     : Has_Block(path, position, b), variable_(var), list_(lst)
     { }
     ATTACH_OPERATIONS();
@@ -359,7 +359,7 @@ namespace Sass {
   class While : public Has_Block {
     ADD_PROPERTY(Expression*, predicate);
   public:
-    While(string path, Position position, Expression* pred, Block* b)
+    While(const string& path, Position position, Expression* pred, Block* b)
     : Has_Block(path, position, b), predicate_(pred)
     { }
     ATTACH_OPERATIONS();
@@ -371,7 +371,7 @@ namespace Sass {
   class Return : public Statement {
     ADD_PROPERTY(Expression*, value);
   public:
-    Return(string path, Position position, Expression* val)
+    Return(const string& path, Position position, Expression* val)
     : Statement(path, position), value_(val)
     { }
     ATTACH_OPERATIONS();
@@ -383,7 +383,7 @@ namespace Sass {
   class Extension : public Statement {
     ADD_PROPERTY(Selector*, selector);
   public:
-    Extension(string path, Position position, Selector* s)
+    Extension(const string& path, Position position, Selector* s)
     : Statement(path, position), selector_(s)
     { }
     ATTACH_OPERATIONS();
@@ -478,9 +478,13 @@ namespace Sass {
   class Mixin_Call : public Has_Block {
     ADD_PROPERTY(string, name);
     ADD_PROPERTY(Arguments*, arguments);
+    // the mixin the call last resolved to, and when (see Expand)
+    ADD_PROPERTY(Definition*, resolved_definition);
+    ADD_PROPERTY(size_t, resolved_version);
   public:
-    Mixin_Call(string path, Position position, string n, Arguments* args, Block* b = 0)
-    : Has_Block(path, position, b), name_(n), arguments_(args)
+    Mixin_Call(const string& path, Position position, string n, Arguments* args, Block* b = 0)
+    : Has_Block(path, position, b), name_(n), arguments_(args),
+      resolved_definition_(0), resolved_version_(0)
     { }
     ATTACH_OPERATIONS();
   };
@@ -490,7 +494,7 @@ namespace Sass {
   ///////////////////////////////////////////////////
   class Content : public Statement {
   public:
-    Content(string path, Position position) : Statement(path, position) { }
+    Content(const string& path, Position position) : Statement(path, position) { }
     ATTACH_OPERATIONS();
   };
 
@@ -517,7 +521,7 @@ namespace Sass {
     ADD_PROPERTY(bool, is_interpolant);
     ADD_PROPERTY(Concrete_Type, concrete_type);
   public:
-    Expression(string path, Position position,
+    Expression(const string& path, Position position,
                bool d = false, bool i = false, Concrete_Type ct = NONE)
     : AST_Node(path, position),
       is_delayed_(d), is_interpolant_(i), concrete_type_(ct)
@@ -534,20 +538,91 @@ namespace Sass {
   ///////////////////////////////////////////////////////////////////////
   // Lists of values, both comma- and space-separated (distinguished by a
   // type-tag.) Also used to represent variable-length argument lists.
+  //
+  // A list appended to an empty one shares its elements with it instead of
+  // copying them, so that building a list by appending to it over and over
+  // takes linear time: each list sees the first `length()` elements of the
+  // buffer, and pushing onto one which ends where the buffer does adds to
+  // the buffer in place. Any other list is given a buffer of its own first,
+  // and so is one whose elements are erased; they mustn't be replaced.
+  // The buffer also remembers how many of its leading elements are known to
+  // evaluate to themselves, so that evaluating a list again doesn't have to
+  // look at them again.
   ///////////////////////////////////////////////////////////////////////
-  class List : public Expression, public Vectorized<Expression*> {
+  class List : public Expression {
   public:
     enum Separator { SPACE, COMMA };
   private:
+    struct Buffer {
+      vector<Expression*> elements;
+      size_t              references;
+      size_t              settled;
+      Buffer(size_t s) : elements(vector<Expression*>()), references(1), settled(0)
+      { elements.reserve(s); }
+    };
+    Buffer* buffer_;
+    size_t  length_;
     ADD_PROPERTY(Separator, separator);
     ADD_PROPERTY(bool, is_arglist);
+    void release()
+    { if (!--buffer_->references) delete buffer_; }
+    void own()
+    {
+      if (buffer_->references == 1 && buffer_->elements.size() == length_) return;
+      Buffer* b = new Buffer(length_);
+      b->elements.assign(buffer_->elements.begin(), buffer_->elements.begin() + length_);
+      b->settled = std::min(buffer_->settled, length_);
+      release();
+      buffer_ = b;
+    }
+    List& operator=(const List&);
   public:
-    List(string path, Position position,
+    List(const string& path, Position position,
          size_t size = 0, Separator sep = SPACE, bool argl = false)
     : Expression(path, position),
-      Vectorized<Expression*>(size),
+      buffer_(new Buffer(size)), length_(0),
       separator_(sep), is_arglist_(argl)
     { concrete_type(LIST); }
+    List(const List& l)
+    : Expression(l),
+      buffer_(new Buffer(l.length_)), length_(l.length_),
+      separator_(l.separator_), is_arglist_(l.is_arglist_)
+    {
+      buffer_->elements.assign(l.buffer_->elements.begin(), l.buffer_->elements.begin() + length_);
+      buffer_->settled = l.settled();
+    }
+    ~List() { release(); }
+    size_t length() const               { return length_; }
+    bool empty() const                  { return !length_; }
+    Expression*& operator[](size_t i)   { return buffer_->elements[i]; }
+    size_t settled() const              { return std::min(buffer_->settled, length_); }
+    void settled(size_t n)              { if (n > buffer_->settled) buffer_->settled = n; }
+    List& operator<<(Expression* element)
+    {
+      if (buffer_->elements.size() != length_) own();
+      buffer_->elements.push_back(element);
+      ++length_;
+      return *this;
+    }
+    List& operator+=(List* l)
+    {
+      if (!length_ && l != this) {
+        ++l->buffer_->references;
+        release();
+        buffer_ = l->buffer_;
+        length_ = l->length_;
+        return *this;
+      }
+      for (size_t i = 0, L = l->length(); i < L; ++i) *this << (*l)[i];
+      return *this;
+    }
+    void erase(size_t i)
+    {
+      own();
+      buffer_->elements.erase(buffer_->elements.begin() + i);
+      buffer_->settled = std::min(buffer_->settled, i);
+      --length_;
+    }
     string type() { return is_arglist_ ? "arglist" : "list"; }
     static string type_name() { return "list"; }
     bool is_invisible() { return !length(); }
@@ -572,10 +647,11 @@ namespace Sass {
     ADD_PROPERTY(Type, type);
     ADD_PROPERTY(Expression*, left);
     ADD_PROPERTY(Expression*, right);
+    ADD_PROPERTY(Expression*, folded); // the value, if it's constant
   public:
-    Binary_Expression(string path, Position position,
+    Binary_Expression(const string& path, Position position,
                       Type t, Expression* lhs, Expression* rhs)
-    : Expression(path, position), type_(t), left_(lhs), right_(rhs)
+    : Expression(path, position), type_(t), left_(lhs), right_(rhs), folded_(0)
     { }
     ATTACH_OPERATIONS();
   };
@@ -589,9 +665,10 @@ namespace Sass {
   private:
     ADD_PROPERTY(Type, type);
     ADD_PROPERTY(Expression*, operand);
+    ADD_PROPERTY(Expression*, folded); // the value, if it's constant
   public:
-    Unary_Expression(string path, Position position, Type t, Expression* o)
-    : Expression(path, position), type_(t), operand_(o)
+    Unary_Expression(const string& path, Position position, Type t, Expression* o)
+    : Expression(path, position), type_(t), operand_(o), folded_(0)
     { }
     ATTACH_OPERATIONS();
   };
@@ -603,12 +680,24 @@ namespace Sass {
     ADD_PROPERTY(string, name);
     ADD_PROPERTY(Arguments*, arguments);
     ADD_PROPERTY(void*, cookie);
-  public:
-    Function_Call(string path, Position position, string n, Arguments* args, void* cookie)
-    : Expression(path, position), name_(n), arguments_(args), cookie_(cookie)
+    // the value of a call to a pure built-in with constant arguments, and
+    // the definition it was computed with
+    ADD_PROPERTY(Expression*, folded);
+    ADD_PROPERTY(Definition*, folded_by);
+    // the function the call last resolved to (0 if none), when, and the
+    // overload it picked for how many arguments (see Eval)
+    ADD_PROPERTY(Definition*, resolved_definition);
+    ADD_PROPERTY(size_t, resolved_version);
+    ADD_PROPERTY(Definition*, resolved_overload);
+    ADD_PROPERTY(size_t, resolved_arity);
+  public:
+    Function_Call(const string& path, Position position, string n, Arguments* args, void* cookie)
+    : Expression(path, position), name_(n), arguments_(args), cookie_(cookie), folded_(0), folded_by_(0),
+      resolved_definition_(0), resolved_version_(0), resolved_overload_(0), resolved_arity_(0)
     { concrete_type(STRING); }
-    Function_Call(string path, Position position, string n, Arguments* args)
-    : Expression(path, position), name_(n), arguments_(args), cookie_(0)
+    Function_Call(const string& path, Position position, string n, Arguments* args)
+    : Expression(path, position), name_(n), arguments_(args), cookie_(0), folded_(0), folded_by_(0),
+      resolved_definition_(0), resolved_version_(0), resolved_overload_(0), resolved_arity_(0)
     { concrete_type(STRING); }
     ATTACH_OPERATIONS();
   };
@@ -620,7 +709,7 @@ namespace Sass {
     ADD_PROPERTY(String*, name);
     ADD_PROPERTY(Arguments*, arguments);
   public:
-    Function_Call_Schema(string path, Position position, String* n, Arguments* args)
+    Function_Call_Schema(const string& path, Position position, String* n, Arguments* args)
     : Expression(path, position), name_(n), arguments_(args)
     { concrete_type(STRING); }
     ATTACH_OPERATIONS();
@@ -630,11 +719,14 @@ namespace Sass {
   // Variable references.
   ///////////////////////
   class Variable : public Expression {
-    ADD_PROPERTY(string, name);
+    ADD_SOURCE_STRING(name);
   public:
-    Variable(string path, Position position, string n)
+    Variable(const string& path, Position position, string n)
     : Expression(path, position), name_(n)
     { }
+    Variable(const string& path, Position position, const Token& tok)
+    : Expression(path, position), name_token_(tok)
+    { }
     ATTACH_OPERATIONS();
   };
 
@@ -647,10 +739,14 @@ namespace Sass {
     enum Type { NUMBER, PERCENTAGE, DIMENSION, HEX };
   private:
     ADD_PROPERTY(Type, type);
-    ADD_PROPERTY(string, value);
+    ADD_SOURCE_STRING(value);
+    ADD_PROPERTY(Expression*, literal); // the decoded number or color
   public:
-    Textual(string path, Position position, Type t, string val)
-    : Expression(path, position, true), type_(t), value_(val)
+    Textual(const string& path, Position position, Type t, string val)
+    : Expression(path, position, true), type_(t), value_(val), literal_(0)
+    { }
+    Textual(const string& path, Position position, Type t, const Token& tok)
+    : Expression(path, position, true), type_(t), value_token_(tok), literal_(0)
     { }
     ATTACH_OPERATIONS();
   };
@@ -663,7 +759,7 @@ namespace Sass {
     vector<string> numerator_units_;
     vector<string> denominator_units_;
   public:
-    Number(string path, Position position, double val, string u = "")
+    Number(const string& path, Position position, double val, string u = "")
     : Expression(path, position),
       value_(val),
       numerator_units_(vector<string>()),
@@ -780,7 +876,7 @@ namespace Sass {
     ADD_PROPERTY(double, a);
     ADD_PROPERTY(string, disp);
   public:
-    Color(string path, Position position, double r, double g, double b, double a = 1, const string disp = "")
+    Color(const string& path, Position position, double r, double g, double b, double a = 1, const string disp = "")
     : Expression(path, position), r_(r), g_(g), b_(b), a_(a), disp_(disp)
     { concrete_type(COLOR); }
     string type() { return "color"; }
@@ -794,7 +890,7 @@ namespace Sass {
   class Boolean : public Expression {
     ADD_PROPERTY(bool, value);
   public:
-    Boolean(string path, Position position, bool val) : Expression(path, position), value_(val)
+    Boolean(const string& path, Position position, bool val) : Expression(path, position), value_(val)
     { concrete_type(BOOLEAN); }
     virtual operator bool() { return value_; }
     string type() { return "bool"; }
@@ -810,7 +906,7 @@ namespace Sass {
   class String : public Expression {
     ADD_PROPERTY(bool, needs_unquoting);
   public:
-    String(string path, Position position, bool unq = false, bool delayed = false)
+    String(const string& path, Position position, bool unq = false, bool delayed = false)
     : Expression(path, position, delayed), needs_unquoting_(unq)
     { concrete_type(STRING); }
     static string type_name() { return "string"; }
@@ -826,7 +922,7 @@ namespace Sass {
   class String_Schema : public String, public Vectorized<Expression*> {
     ADD_PROPERTY(char, quote_mark);
   public:
-    String_Schema(string path, Position position, size_t size = 0, bool unq = false, char qm = '\0')
+    String_Schema(const string& path, Position position, size_t size = 0, bool unq = false, char qm = '\0')
     : String(path, position, unq), Vectorized<Expression*>(size), quote_mark_(qm)
     { }
     string type() { return "string"; }
@@ -838,24 +934,24 @@ namespace Sass {
   // Flat strings -- the lowest level of raw textual data.
   ////////////////////////////////////////////////////////
   class String_Constant : public String {
-    ADD_PROPERTY(string, value);
+    ADD_SOURCE_STRING(value);
   public:
-    String_Constant(string path, Position position, string val, bool unq = false)
+    String_Constant(const string& path, Position position, string val, bool unq = false)
     : String(path, position, unq, true), value_(val)
     { }
-    String_Constant(string path, Position position, const char* beg, bool unq = false)
+    String_Constant(const string& path, Position position, const char* beg, bool unq = false)
     : String(path, position, unq, true), value_(string(beg))
     { }
-    String_Constant(string path, Position position, const char* beg, const char* end, bool unq = false)
+    String_Constant(const string& path, Position position, const char* beg, const char* end, bool unq = false)
     : String(path, position, unq, true), value_(string(beg, end-beg))
     { }
-    String_Constant(string path, Position position, const Token& tok, bool unq = false)
-    : String(path, position, unq, true), value_(string(tok.begin, tok.end))
+    String_Constant(const string& path, Position position, const Token& tok, bool unq = false)
+    : String(path, position, unq, true), value_token_(tok)
     { }
     string type() { return "string"; }
     static string type_name() { return "string"; }
-    bool is_quoted() { return value_.length() && (value_[0] == '"' || value_[0] == '\''); }
-    char quote_mark() { return is_quoted() ? value_[0] : '\0'; }
+    bool is_quoted() { return value().length() && (value()[0] == '"' || value()[0] == '\''); }
+    char quote_mark() { return is_quoted() ? value()[0] : '\0'; }
     ATTACH_OPERATIONS();
   };
 
@@ -868,7 +964,7 @@ namespace Sass {
     ADD_PROPERTY(bool, is_negated);
     ADD_PROPERTY(bool, is_restricted);
   public:
-    Media_Query(string path, Position position,
+    Media_Query(const string& path, Position position,
                 String* t = 0, size_t s = 0, bool n = false, bool r = false)
     : Expression(path, position), Vectorized<Media_Query_Expression*>(s),
       media_type_(t), is_negated_(n), is_restricted_(r)
@@ -884,7 +980,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, value);
     ADD_PROPERTY(bool, is_interpolated);
   public:
-    Media_Query_Expression(string path, Position position,
+    Media_Query_Expression(const string& path, Position position,
                            Expression* f, Expression* v, bool i = false)
     : Expression(path, position), feature_(f), value_(v), is_interpolated_(i)
     { }
@@ -896,7 +992,7 @@ namespace Sass {
   //////////////////
   class Null : public Expression {
   public:
-    Null(string path, Position position) : Expression(path, position) { concrete_type(NULL_VAL); }
+    Null(const string& path, Position position) : Expression(path, position) { concrete_type(NULL_VAL); }
     string type() { return "null"; }
     static string type_name() { return "null"; }
     bool is_invisible() { return true; }
@@ -912,7 +1008,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, expression);
     ADD_PROPERTY(Env*, environment);
   public:
-    Thunk(string path, Position position, Expression* exp, Env* env = 0)
+    Thunk(const string& path, Position position, Expression* exp, Env* env = 0)
     : Expression(path, position), expression_(exp), environment_(env)
     { }
   };
@@ -972,12 +1068,20 @@ namespace Sass {
       }
     }
   public:
-    Parameters(string path, Position position)
+    Parameters(const string& path, Position position)
     : AST_Node(path, position),
       Vectorized<Parameter*>(),
       has_optional_parameters_(false),
       has_rest_parameter_(false)
     { }
+    // parameter lists are short; scanning them is cheaper than a map
+    Parameter* named(const string& name)
+    {
+      for (size_t i = 0, L = length(); i < L; ++i) {
+        if ((*this)[i]->name() == name) return (*this)[i];
+      }
+      return 0;
+    }
     ATTACH_OPERATIONS();
   };
 
@@ -1040,7 +1144,7 @@ namespace Sass {
       }
     }
   public:
-    Arguments(string path, Position position)
+    Arguments(const string& path, Position position)
     : Expression(path, position),
       Vectorized<Argument*>(),
       has_named_arguments_(false),
@@ -1056,7 +1160,7 @@ namespace Sass {
     ADD_PROPERTY(bool, has_reference);
     ADD_PROPERTY(bool, has_placeholder);
   public:
-    Selector(string path, Position position, bool r = false, bool h = false)
+    Selector(const string& path, Position position, bool r = false, bool h = false)
     : AST_Node(path, position), has_reference_(r), has_placeholder_(h)
     { }
     virtual ~Selector() = 0;
@@ -1072,7 +1176,7 @@ namespace Sass {
   class Selector_Schema : public Selector {
     ADD_PROPERTY(String*, contents);
   public:
-    Selector_Schema(string path, Position position, String* c)
+    Selector_Schema(const string& path, Position position, String* c)
     : Selector(path, position), contents_(c)
     { }
     ATTACH_OPERATIONS();
@@ -1083,7 +1187,7 @@ namespace Sass {
   ////////////////////////////////////////////
   class Simple_Selector : public Selector {
   public:
-    Simple_Selector(string path, Position position)
+    Simple_Selector(const string& path, Position position)
     : Selector(path, position)
     { }
     virtual ~Simple_Selector() = 0;
@@ -1098,7 +1202,7 @@ namespace Sass {
   class Selector_Reference : public Simple_Selector {
     ADD_PROPERTY(Selector*, selector);
   public:
-    Selector_Reference(string path, Position position, Selector* r = 0)
+    Selector_Reference(const string& path, Position position, Selector* r = 0)
     : Simple_Selector(path, position), selector_(r)
     { has_reference(true); }
     virtual int specificity()
@@ -1115,7 +1219,7 @@ namespace Sass {
   class Selector_Placeholder : public Simple_Selector {
     ADD_PROPERTY(string, name);
   public:
-    Selector_Placeholder(string path, Position position, string n)
+    Selector_Placeholder(const string& path, Position position, string n)
     : Simple_Selector(path, position), name_(n)
     { has_placeholder(true); }
     virtual Selector_Placeholder* find_placeholder();
@@ -1128,7 +1232,7 @@ namespace Sass {
   class Type_Selector : public Simple_Selector {
     ADD_PROPERTY(string, name);
   public:
-    Type_Selector(string path, Position position, string n)
+    Type_Selector(const string& path, Position position, string n)
     : Simple_Selector(path, position), name_(n)
     { }
     virtual int specificity()
@@ -1146,7 +1250,7 @@ namespace Sass {
   class Selector_Qualifier : public Simple_Selector {
     ADD_PROPERTY(string, name);
   public:
-    Selector_Qualifier(string path, Position position, string n)
+    Selector_Qualifier(const string& path, Position position, string n)
     : Simple_Selector(path, position), name_(n)
     { }
     virtual int specificity()
@@ -1166,7 +1270,7 @@ namespace Sass {
     ADD_PROPERTY(string, matcher);
     ADD_PROPERTY(String*, value); // might be interpolated
   public:
-    Attribute_Selector(string path, Position position, string n, string m, String* v)
+    Attribute_Selector(const string& path, Position position, string n, string m, String* v)
     : Simple_Selector(path, position), name_(n), matcher_(m), value_(v)
     { }
     ATTACH_OPERATIONS();
@@ -1179,7 +1283,7 @@ namespace Sass {
     ADD_PROPERTY(string, name);
     ADD_PROPERTY(String*, expression);
   public:
-    Pseudo_Selector(string path, Position position, string n, String* expr = 0)
+    Pseudo_Selector(const string& path, Position position, string n, String* expr = 0)
     : Simple_Selector(path, position), name_(n), expression_(expr)
     { }
     virtual int specificity()
@@ -1210,7 +1314,7 @@ namespace Sass {
   class Negated_Selector : public Simple_Selector {
     ADD_PROPERTY(Selector*, selector);
   public:
-    Negated_Selector(string path, Position position, Selector* sel)
+    Negated_Selector(const string& path, Position position, Selector* sel)
     : Simple_Selector(path, position), selector_(sel)
     { }
     ATTACH_OPERATIONS();
@@ -1230,7 +1334,7 @@ namespace Sass {
       if (s->has_placeholder()) has_placeholder(true);
     }
   public:
-    Compound_Selector(string path, Position position, size_t s = 0)
+    Compound_Selector(const string& path, Position position, size_t s = 0)
     : Selector(path, position),
       Vectorized<Simple_Selector*>(s)
     { }
@@ -1278,7 +1382,7 @@ namespace Sass {
     ADD_PROPERTY(Compound_Selector*, head);
     ADD_PROPERTY(Complex_Selector*, tail);
   public:
-    Complex_Selector(string path, Position position,
+    Complex_Selector(const string& path, Position position,
                          Combinator c,
                          Compound_Selector* h,
                          Complex_Selector* t)
@@ -1341,7 +1445,7 @@ namespace Sass {
       if (c->has_placeholder()) has_placeholder(true);
     }
   public:
-    Selector_List(string path, Position position, size_t s = 0)
+    Selector_List(const string& path, Position position, size_t s = 0)
     : Selector(path, position), Vectorized<Complex_Selector*>(s)
     { }
     virtual Selector_Placeholder* find_placeholder();
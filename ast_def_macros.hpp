@@ -7,10 +7,32 @@ virtual Selector* perform(Operation<Selector*>* op) { return (*op)(this); }\
 virtual string perform(Operation<string>* op) { return (*op)(this); }\
 virtual Sass_Value perform(Operation<Sass_Value>* op) { return (*op)(this); }
 
+// Getters return a reference to the member itself, which follows any later
+// set (and for containers, loses its iterators to it): copy whatever has to
+// stay the same while the node may be changed.
 #define ADD_PROPERTY(type, name)\
 protected:\
   type name##_;\
 public:\
-  type name() const        { return name##_; }\
+  type const& name() const { return name##_; }\
   type name(type name##__) { return name##_ = name##__; }\
 private:
+
+// A string property which can refer to the slice of the source it was
+// parsed from (sources live as long as the context does); it's copied
+// out into a string of its own the first time it's read.
+#define ADD_SOURCE_STRING(name)\
+protected:\
+  mutable Token name##_token_;\
+  mutable string name##_;\
+public:\
+  string const& name() const\
+  {\
+    if (name##_token_.begin) {\
+      name##_.assign(name##_token_.begin, name##_token_.end);\
+      name##_token_ = Token();\
+    }\
+    return name##_;\
+  }\
+  string name(string name##__) { name##_token_ = Token(); return name##_ = name##__; }\
+private:
@@ -10,20 +10,37 @@ namespace Sass {
 
   using namespace std;
 
+  // Frames live on the stack of the evaluator for the duration of a call,
+  // and only refer to the strings of the nodes they were made for; the
+  // trace is formatted only when it's reported.  They're given pointers
+  // rather than references so that they can't be made for temporaries:
+  // a path or a name has to stay put (and unchanged) as long as the frame.
   struct Backtrace {
 
-    Backtrace* parent;
-    string     path;
-    Position   position;
-    string     caller;
+    Backtrace*    parent;
+    const string* path;
+    Position      position;
+    const char*   kind; // "function" or "mixin" for calls, 0 otherwise
+    const string* name;
 
-    Backtrace(Backtrace* prn, string pth, Position position, string c)
+    // the root of a trace, an empty placeholder
+    Backtrace()
+    : parent(0), path(0), position(Position()), kind(0), name(0)
+    { }
+
+    Backtrace(Backtrace* prn, const string* pth, Position position, const char* k = 0, const string* n = 0)
     : parent(prn),
       path(pth),
       position(position),
-      caller(c)
+      kind(k),
+      name(n)
     { }
 
+    void caller_to_stream(stringstream& ss)
+    {
+      if (kind) ss << ", in " << kind << " `" << *name << "`";
+    }
+
     string to_string(bool warning = false)
     {
       stringstream ss;
@@ -35,10 +52,10 @@ namespace Sass {
         ss << endl
            << "\t"
            << (warning ? " " : "")
-           << this_point->path
+           << *this_point->path
            << ":"
-           << this_point->position.line
-           << this_point->parent->caller;
+           << this_point->position.line();
+        this_point->parent->caller_to_stream(ss);
         this_point = this_point->parent;
       }
 
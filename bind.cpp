@@ -12,17 +12,11 @@ namespace Sass {
 
   void bind(string callee, Parameters* ps, Arguments* as, Context& ctx, Env* env, Eval* eval)
   {
-    map<string, Parameter*> param_map;
-
-    // Set up a map to ensure named arguments refer to actual parameters. Also
-    // eval each default value left-to-right, wrt env, populating env as we go.
-    for (size_t i = 0, L = ps->length(); i < L; ++i) {
-      Parameter*  p = (*ps)[i];
-      param_map[p->name()] = p;
-      // if (p->default_value()) {
-      //   env->current_frame()[p->name()] = p->default_value()->perform(eval->with(env));
-      // }
-    }
+    // bind straight into the callee's frame; each parameter takes a single
+    // lookup in it, and named arguments are matched against the parameter
+    // list itself rather than a map built for every call
+    map<string, AST_Node*>& frame = env->current_frame();
+    typedef map<string, AST_Node*>::iterator slot_iter;
 
     // plug in all args; if we have leftover params, deal with it later
     size_t ip = 0, LP = ps->length();
@@ -41,12 +35,9 @@ namespace Sass {
       if (p->is_rest_parameter()) {
         if (a->is_rest_argument()) {
           // rest param and rest arg -- just add one to the other
-          if (env->current_frame_has(p->name())) {
-            *static_cast<List*>(env->current_frame()[p->name()])
-            += static_cast<List*>(a->value());
-          }
-          else {
-            env->current_frame()[p->name()] = a->value();
+          pair<slot_iter, bool> slot = frame.insert(make_pair(p->name(), static_cast<AST_Node*>(a->value())));
+          if (!slot.second) {
+            *static_cast<List*>(slot.first->second) += static_cast<List*>(a->value());
           }
         } else {
 
@@ -56,7 +47,7 @@ namespace Sass {
                                              0,
                                              List::COMMA,
                                              true);
-          env->current_frame()[p->name()] = arglist;
+          frame[p->name()] = arglist;
           while (ia < LA) {
             a = (*as)[ia];
             (*arglist) << new (ctx.mem) Argument(a->path(),
@@ -86,7 +77,7 @@ namespace Sass {
           Expression* a_to_convert = (*arglist)[0];
           a = new (ctx.mem) Argument(a_to_convert->path(), a_to_convert->position(), a_to_convert, "", false);
         }
-        arglist->elements().erase(arglist->elements().begin());
+        arglist->erase(0);
         if (!arglist->length() || (!arglist->is_arglist() && ip + 1 == LP)) {
           ++ia;
         }
@@ -95,36 +86,35 @@ namespace Sass {
       }
 
       if (a->name().empty()) {
-        if (env->current_frame_has(p->name())) {
+        // ordinal arg -- bind it to the next param
+        if (!frame.insert(make_pair(p->name(), static_cast<AST_Node*>(a->value()))).second) {
           stringstream msg;
           msg << "parameter " << p->name()
           << " provided more than once in call to " << callee;
           error(msg.str(), a->path(), a->position());
         }
-        // ordinal arg -- bind it to the next param
-        env->current_frame()[p->name()] = a->value();
         ++ip;
       }
       else {
         // named arg -- bind it to the appropriately named param
-        if (!param_map.count(a->name())) {
+        Parameter* np = ps->named(a->name());
+        if (!np) {
           stringstream msg;
           msg << callee << " has no parameter named " << a->name();
           error(msg.str(), a->path(), a->position());
         }
-        if (param_map[a->name()]->is_rest_parameter()) {
+        if (np->is_rest_parameter()) {
           stringstream msg;
           msg << "argument " << a->name() << " of " << callee
               << "cannot be used as named argument";
           error(msg.str(), a->path(), a->position());
         }
-        if (env->current_frame_has(a->name())) {
+        if (!frame.insert(make_pair(a->name(), static_cast<AST_Node*>(a->value()))).second) {
           stringstream msg;
           msg << "parameter " << p->name()
               << "provided more than once in call to " << callee;
           error(msg.str(), a->path(), a->position());
         }
-        env->current_frame()[a->name()] = a->value();
       }
     }
 
@@ -132,18 +122,19 @@ namespace Sass {
     // That's only okay if they have default values, or were already bound by
     // named arguments, or if it's a single rest-param.
     for (size_t i = ip; i < LP; ++i) {
-      To_String to_string;
       Parameter* leftover = (*ps)[i];
       // cerr << "env for default params:" << endl;
       // env->print();
       // cerr << "********" << endl;
-      if (!env->current_frame_has(leftover->name())) {
+      slot_iter slot = frame.lower_bound(leftover->name());
+      if (slot == frame.end() || slot->first != leftover->name()) {
         if (leftover->is_rest_parameter()) {
-          env->current_frame()[leftover->name()] = new (ctx.mem) List(leftover->path(),
-                                                                      leftover->position(),
-                                                                      0,
-                                                                      List::COMMA,
-                                                                      true);
+          frame.insert(slot, make_pair(leftover->name(),
+                                       static_cast<AST_Node*>(new (ctx.mem) List(leftover->path(),
+                                                                                 leftover->position(),
+                                                                                 0,
+                                                                                 List::COMMA,
+                                                                                 true))));
         }
         else if (leftover->default_value()) {
           // make sure to eval the default value in the env that we've been populating
@@ -153,7 +144,7 @@ namespace Sass {
           eval->env = old_env;
           eval->backtrace = old_bt;
           // dv->perform(&to_string);
-          env->current_frame()[leftover->name()] = dv;
+          frame.insert(slot, make_pair(leftover->name(), static_cast<AST_Node*>(dv)));
         }
         else {
           // param is unbound and has no default value -- error
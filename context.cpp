@@ -31,6 +31,7 @@
 #include "prelexer.hpp"
 #endif
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <cstring>
@@ -48,6 +49,7 @@ namespace Sass {
     include_paths   (initializers.include_paths()),
     queue           (vector<pair<string, const char*> >()),
     style_sheets    (map<string, Block*>()),
+    source_cache    (initializers.source_cache()),
     source_map(File::base_name(initializers.output_path())),
     c_functions     (vector<Sass_C_Function_Descriptor>()),
     image_path      (initializers.image_path()),
@@ -58,6 +60,18 @@ namespace Sass {
     names_to_colors (map<string, Color*>()),
     colors_to_names (map<int, string>()),
     precision       (initializers.precision()),
+    parsed_selectors(map<pair<Selector_Schema*, string>, Selector*>()),
+    parsed_selector_hits(0),
+    parsed_selector_misses(0),
+    function_purities(map<Definition*, Function_Purity>()),
+    function_results(map<pair<Definition*, string>, Expression*>()),
+    mixin_results(map<pair<Definition*, string>, vector<Statement*> >()),
+    definitions_version(1),
+    has_local_definitions(false),
+    null_value(new (mem) Null("[SHARED VALUE]", Position())),
+    true_value(new (mem) Boolean("[SHARED VALUE]", Position(), true)),
+    false_value(new (mem) Boolean("[SHARED VALUE]", Position(), false)),
+    small_integers(vector<Number*>()),
     extensions(multimap<Compound_Selector, Complex_Selector*>()),
     subset_map(Subset_Map<string, pair<Complex_Selector*, Compound_Selector*> >())
   {
@@ -78,7 +92,57 @@ namespace Sass {
   }
 
   Context::~Context()
-  { for (size_t i = 0; i < sources.size(); ++i) delete[] sources[i]; }
+  {
+    for (size_t i = 0; i < sources.size(); ++i) delete[] sources[i];
+    for (size_t i = 0; i < line_indices.size(); ++i) delete line_indices[i];
+  }
+
+  const size_t NUM_SMALL_INTEGERS = 256;
+
+  bool Context::is_shared(Expression* e)
+  {
+    switch (e->concrete_type())
+    {
+      case Expression::NULL_VAL: return e == null_value;
+      case Expression::BOOLEAN:  return e == true_value || e == false_value;
+      case Expression::NUMBER: {
+        double value = static_cast<Number*>(e)->value();
+        if (value < 0 || value >= small_integers.size()) return false;
+        size_t i = static_cast<size_t>(value);
+        return i == value && small_integers[i] == e;
+      }
+      default:                   return false;
+    }
+  }
+
+  Number* Context::unitless_number(const string& path, Position position, double value)
+  {
+    // source maps need the position of every value, which a shared one lacks
+    if (source_maps || value < 0 || value >= NUM_SMALL_INTEGERS || value != static_cast<size_t>(value)) {
+      return new (mem) Number(path, position, value);
+    }
+    if (small_integers.empty()) small_integers.resize(NUM_SMALL_INTEGERS, 0);
+    Number*& n = small_integers[static_cast<size_t>(value)];
+    if (!n) n = new (mem) Number("[SHARED VALUE]", Position(), value);
+    return n;
+  }
+
+  // a copy of `e` placed at `path` and `position` if it's shared, so that
+  // it can be modified; otherwise `e` itself
+  Expression* Context::unshare(Expression* e, const string& path, Position position)
+  {
+    if (!is_shared(e)) return e;
+    Expression* copy = 0;
+    switch (e->concrete_type())
+    {
+      case Expression::NULL_VAL: copy = new (mem) Null(*static_cast<Null*>(e));       break;
+      case Expression::BOOLEAN:  copy = new (mem) Boolean(*static_cast<Boolean*>(e)); break;
+      default:                   copy = new (mem) Number(*static_cast<Number*>(e));   break;
+    }
+    copy->path(path);
+    copy->position(position);
+    return copy;
+  }
 
   void Context::setup_color_map()
   {
@@ -145,17 +209,13 @@ namespace Sass {
     using namespace File;
     char* contents = 0;
     string real_path;
+    unsigned long long hash;
     for (size_t i = 0, S = include_paths.size(); i < S; ++i) {
       string full_path(join_paths(include_paths[i], path));
-      included_files.push_back(full_path);
       if (style_sheets.count(full_path)) return full_path;
-      contents = resolve_and_load(full_path, real_path);
+      contents = resolve_and_load(full_path, real_path, &hash, source_cache);
       if (contents) {
-        sources.push_back(contents);
-        included_files.push_back(real_path);
-        queue.push_back(make_pair(full_path, contents));
-        source_map.files.push_back(resolve_relative_path(real_path, source_map_file, cwd));
-        style_sheets[full_path] = 0;
+        enqueue_file(full_path, real_path, contents, hash);
         return full_path;
       }
     }
@@ -167,33 +227,67 @@ namespace Sass {
     using namespace File;
     char* contents = 0;
     string real_path;
+    unsigned long long hash;
     string full_path(join_paths(dir, rel_filepath));
     if (style_sheets.count(full_path)) return full_path;
-    contents = resolve_and_load(full_path, real_path);
+    contents = resolve_and_load(full_path, real_path, &hash, source_cache);
     if (contents) {
-      sources.push_back(contents);
-      included_files.push_back(real_path);
-      queue.push_back(make_pair(full_path, contents));
-      source_map.files.push_back(resolve_relative_path(real_path, source_map_file, cwd));
-      style_sheets[full_path] = 0;
+      enqueue_file(full_path, real_path, contents, hash);
       return full_path;
     }
     for (size_t i = 0, S = include_paths.size(); i < S; ++i) {
       string full_path(join_paths(include_paths[i], rel_filepath));
       if (style_sheets.count(full_path)) return full_path;
-      contents = resolve_and_load(full_path, real_path);
+      contents = resolve_and_load(full_path, real_path, &hash, source_cache);
       if (contents) {
-        sources.push_back(contents);
-        included_files.push_back(real_path);
-        queue.push_back(make_pair(full_path, contents));
-        source_map.files.push_back(resolve_relative_path(real_path, source_map_file, cwd));
-        style_sheets[full_path] = 0;
+        enqueue_file(full_path, real_path, contents, hash);
         return full_path;
       }
     }
     return string();
   }
 
+  // 64-bit FNV-1a, as a hex string
+  static string hex_hash(unsigned long long hash)
+  {
+    stringstream ss;
+    ss << std::hex << setfill('0') << setw(16) << hash;
+    return ss.str();
+  }
+
+  // Text to be parsed during evaluation is kept as long as the sources,
+  // since the nodes parsed out of it may refer to it instead of copying it.
+  const char* Context::add_text(const string& text)
+  {
+    char* contents = new char[text.size() + 1];
+    text.copy(contents, text.size());
+    contents[text.size()] = '\0';
+    sources.push_back(contents);
+    return contents;
+  }
+
+  void Context::enqueue_file(const string& full_path, const string& real_path, char* contents, unsigned long long hash)
+  {
+    sources.push_back(contents);
+    included_files.push_back(real_path);
+    queue.push_back(make_pair(full_path, contents));
+    source_map.files.push_back(File::resolve_relative_path(real_path, source_map_file, cwd));
+    style_sheets[full_path] = 0;
+    Included_File node;
+    node.path = real_path;
+    node.hash = hex_hash(hash);
+    import_graph_indices[full_path] = import_graph.size();
+    import_graph.push_back(node);
+  }
+
+  void Context::add_import(const string& importer, const string& imported)
+  {
+    if (!import_graph_indices.count(importer) || !import_graph_indices.count(imported)) return;
+    vector<size_t>& imports = import_graph[import_graph_indices[importer]].imports;
+    size_t index = import_graph_indices[imported];
+    if (find(imports.begin(), imports.end(), index) == imports.end()) imports.push_back(index);
+  }
+
   void register_function(Context&, Signature sig, Native_Function f, Env* env);
   void register_function(Context&, Signature sig, Native_Function f, size_t arity, Env* env);
   void register_overload_stub(Context&, string name, Env* env);
@@ -206,12 +300,13 @@ namespace Sass {
     Block* root = 0;
     for (size_t i = 0; i < queue.size(); ++i) {
       Parser p(Parser::from_c_str(queue[i].second, *this, queue[i].first, Position(1 + i, 1, 1)));
+      p.index_lines();
       Block* ast = p.parse();
       if (i == 0) root = ast;
       style_sheets[queue[i].first] = ast;
     }
     Env tge;
-    Backtrace backtrace(0, "", Position(), "");
+    Backtrace backtrace;
     register_built_in_functions(*this, &tge);
     for (size_t i = 0, S = c_functions.size(); i < S; ++i) {
     	register_c_function(*this, &tge, c_functions[i]);
@@ -269,6 +364,12 @@ namespace Sass {
     if (!source_c_str) return 0;
     queue.clear();
     queue.push_back(make_pair("source string", source_c_str));
+    Included_File node;
+    node.hash = hex_hash(File::hash_contents(source_c_str));
+    import_graph.clear();
+    import_graph_indices.clear();
+    import_graph_indices["source string"] = 0;
+    import_graph.push_back(node);
     return compile_file();
   }
 
@@ -279,6 +380,9 @@ namespace Sass {
       return included_files;
   }
 
+  const vector<Included_File>& Context::get_import_graph() const
+  { return import_graph; }
+
   string Context::get_cwd()
   {
     const size_t wd_len = 1024;
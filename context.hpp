@@ -27,8 +27,16 @@ namespace Sass {
   using namespace std;
   class AST_Node;
   class Block;
+  class Statement;
   class Expression;
   class Color;
+  class Boolean;
+  class Number;
+  class Null;
+  class Selector;
+  class Selector_Schema;
+  class Definition;
+  class Source_Cache;
   struct Backtrace;
   // typedef const char* Signature;
   // struct Context;
@@ -37,14 +45,33 @@ namespace Sass {
 
   enum Output_Style { NESTED, EXPANDED, COMPACT, COMPRESSED, FORMATTED };
 
+  // a node of the import graph: a file loaded by the compile, a hash of
+  // its contents, and the files it imports (indices into the graph)
+  struct Included_File {
+    string         path;
+    string         hash;
+    vector<size_t> imports;
+  };
+
+  // what's known about a user-defined function or mixin whose calls may be
+  // memoized: the variables from outside of it which its result depends
+  // on, and the ones it assigns, which mustn't exist outside of it
+  struct Function_Purity {
+    bool           pure;
+    vector<string> free_variables;
+    vector<string> locals;
+  };
+
   struct Context {
     Memory_Manager<AST_Node> mem;
 
     const char* source_c_str;
-    vector<const char*> sources; // c-strs containing Sass file contents
+    vector<const char*> sources; // c-strs containing Sass file contents, and text parsed during evaluation
+    vector<Line_Index*> line_indices; // of the sources, for the positions of their nodes
     vector<string> include_paths;
     vector<pair<string, const char*> > queue; // queue of files to be parsed
     map<string, Block*> style_sheets; // map of paths to ASTs
+    Source_Cache* source_cache; // of the files loaded, if they're kept across compiles
     SourceMap source_map;
     vector<Sass_C_Function_Descriptor> c_functions;
 
@@ -59,6 +86,40 @@ namespace Sass {
 
     size_t precision; // precision for outputting fractional numbers
 
+    // selectors parsed out of interpolated selectors, keyed by the schema
+    // and the text it evaluated to (see Contextualize)
+    map<pair<Selector_Schema*, string>, Selector*> parsed_selectors;
+    size_t parsed_selector_hits;
+    size_t parsed_selector_misses;
+
+    // results of calls to pure functions, keyed by the definition and the
+    // evaluated arguments (see Eval); dropped whenever a function is defined
+    map<Definition*, Function_Purity> function_purities;
+    map<pair<Definition*, string>, Expression*> function_results;
+
+    // the statements expanded from includes of pure mixins without content
+    // blocks, keyed the same way (see Expand); dropped whenever a function
+    // or mixin is defined
+    map<pair<Definition*, string>, vector<Statement*> > mixin_results;
+
+    // bumped whenever a function or mixin is defined; the definitions calls
+    // resolve to are cached on them for as long as it stays the same, but
+    // only while everything is defined at the top level, since definitions
+    // in local scopes disappear with them
+    size_t definitions_version;
+    bool   has_local_definitions;
+
+    // values which are shared by everything that evaluates to them: null,
+    // the booleans, and small unitless integers (made as they're needed);
+    // they mustn't be modified, so anything that would copies them first
+    Null*           null_value;
+    Boolean*        true_value;
+    Boolean*        false_value;
+    vector<Number*> small_integers;
+    bool is_shared(Expression*);
+    Number* unitless_number(const string& path, Position position, double value);
+    Expression* unshare(Expression*, const string& path, Position position);
+
     KWD_ARG_SET(Data) {
       KWD_ARG(Data, const char*,     source_c_str);
       KWD_ARG(Data, string,          entry_point);
@@ -72,6 +133,7 @@ namespace Sass {
       KWD_ARG(Data, Output_Style,    output_style);
       KWD_ARG(Data, string,          source_map_file);
       KWD_ARG(Data, size_t,          precision);
+      KWD_ARG(Data, Source_Cache*,   source_cache);
     };
 
     Context(Data);
@@ -81,17 +143,23 @@ namespace Sass {
     void setup_color_map();
     string add_file(string);
     string add_file(string, string);
+    void add_import(const string& importer, const string& imported);
+    const char* add_text(const string& text);
     char* compile_string();
     char* compile_file();
     char* generate_source_map();
 
     std::vector<string> get_included_files();
+    const vector<Included_File>& get_import_graph() const;
 
   private:
+    void enqueue_file(const string& full_path, const string& real_path, char* contents, unsigned long long hash);
     string format_source_mapping_url(const string& file) const;
     string get_cwd();
 
     vector<string> included_files;
+    vector<Included_File> import_graph; // parallel to the queue
+    map<string, size_t> import_graph_indices;
     string cwd;
 
     // void register_built_in_functions(Env* env);
@@ -30,8 +30,22 @@ namespace Sass {
   {
     To_String to_string;
     string result_str(s->contents()->perform(eval->with(env, backtrace))->perform(&to_string));
-    result_str += '{'; // the parser looks for a brace to end the selector
-    Selector* result_sel = Parser::from_c_str(result_str.c_str(), ctx, s->path(), s->position()).parse_selector_group();
+    // the parsed selector is contextualized like any selector of the AST,
+    // which doesn't modify it, so it's reused whenever the schema
+    // evaluates to the same text again
+    pair<Selector_Schema*, string> key(s, result_str);
+    map<pair<Selector_Schema*, string>, Selector*>::iterator cached = ctx.parsed_selectors.find(key);
+    Selector* result_sel;
+    if (cached != ctx.parsed_selectors.end()) {
+      result_sel = cached->second;
+      ++ctx.parsed_selector_hits;
+    }
+    else {
+      result_str += '{'; // the parser looks for a brace to end the selector
+      result_sel = Parser::from_c_str(ctx.add_text(result_str), ctx, s->path(), s->position()).parse_selector_group();
+      ctx.parsed_selectors[key] = result_sel;
+      ++ctx.parsed_selector_misses;
+    }
     return result_sel->perform(this);
   }
 
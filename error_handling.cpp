@@ -7,8 +7,10 @@
 
 namespace Sass {
 
+  // the line and column are worked out here: the line index of the
+  // position goes with the context, which the error may outlive
   Error::Error(Type type, string path, Position position, string message)
-  : type(type), path(path), position(position), message(message)
+  : type(type), path(path), position(position.file, position.line(), position.column()), message(message)
   { }
 
   void error(string msg, string path, Position position)
@@ -19,7 +21,7 @@ namespace Sass {
     if (!path.empty() && Prelexer::string_constant(path.c_str()))
       path = path.substr(1, path.size() - 1);
 
-    Backtrace top(bt, path, position, "");
+    Backtrace top(bt, &path, position);
     msg += top.to_string();
 
     throw Error(Error::syntax, path, position, msg);
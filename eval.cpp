@@ -13,6 +13,9 @@
 #include <iostream>
 #include <iomanip>
 #include <typeinfo>
+#include <algorithm>
+#include <set>
+#include <cstring>
 
 namespace Sass {
   using namespace std;
@@ -28,6 +31,309 @@ namespace Sass {
     add, sub, mul, div, fmod
   };
 
+  // built-in functions whose results depend only on their arguments
+  // (sorted, for binary search)
+  static const char* pure_built_ins[] = {
+    "abs", "adjust-color", "adjust-hue", "alpha", "blue", "ceil",
+    "change-color", "comparable", "complement", "darken", "desaturate",
+    "fade-in", "fade-out", "floor", "grayscale", "green", "hsl", "hsla",
+    "hue", "ie-hex-str", "invert", "lighten", "lightness", "max", "min",
+    "mix", "opacify", "opacity", "percentage", "red", "rgb", "rgba",
+    "round", "saturate", "saturation", "scale-color", "transparentize",
+    "unit", "unitless"
+  };
+
+  static bool c_str_less(const char* a, const char* b) { return strcmp(a, b) < 0; }
+
+  static bool is_pure_built_in(const string& name)
+  {
+    const char** end = pure_built_ins + sizeof(pure_built_ins) / sizeof(pure_built_ins[0]);
+    const char** found = lower_bound(pure_built_ins, end, name.c_str(), c_str_less);
+    return found != end && name == *found;
+  }
+
+  // Literals, and operations on constants which have already been folded,
+  // evaluate to the same value every time.  Folded function calls don't
+  // count, since the function may be redefined after they were folded.
+  static bool is_constant(Expression* e)
+  {
+    const type_info& t = typeid(*e);
+    if (t == typeid(Textual))           return true;
+    if (t == typeid(Binary_Expression)) return static_cast<Binary_Expression*>(e)->folded() != 0;
+    if (t == typeid(Unary_Expression))  return static_cast<Unary_Expression*>(e)->folded() != 0;
+    return false;
+  }
+
+  // evaluated values may be modified by whoever gets them, so a folded
+  // value is never handed out itself, except for the shared booleans
+  // (unless source maps need their positions); returns 0 for values which
+  // aren't worth folding
+  static Expression* copy_constant(Context& ctx, Expression* e)
+  {
+    switch (e->concrete_type())
+    {
+      case Expression::NUMBER:  return new (ctx.mem) Number(*static_cast<Number*>(e));
+      case Expression::COLOR:   return new (ctx.mem) Color(*static_cast<Color*>(e));
+      case Expression::BOOLEAN:
+        if (ctx.source_maps) return new (ctx.mem) Boolean(*static_cast<Boolean*>(e));
+        return static_cast<Boolean*>(e)->value() ? ctx.true_value : ctx.false_value;
+      case Expression::STRING:
+        if (typeid(*e) == typeid(String_Constant)) {
+          return new (ctx.mem) String_Constant(*static_cast<String_Constant*>(e));
+        }
+        return 0;
+      default:                  return 0;
+    }
+  }
+
+  const size_t MAX_KEYED_LIST_LENGTH = 32;
+
+  // Appends a key identifying an evaluated value to `key`; returns false
+  // for values which can't be told apart this way.
+  static bool append_value_key(Expression* e, string& key)
+  {
+    switch (e->concrete_type())
+    {
+      case Expression::NUMBER: {
+        Number* n = static_cast<Number*>(e);
+        double v = n->value();
+        key += 'n';
+        key.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        key += n->unit();
+        key += '\0';
+      } return true;
+      case Expression::COLOR: {
+        Color* c = static_cast<Color*>(e);
+        double rgba[4] = { c->r(), c->g(), c->b(), c->a() };
+        key += 'c';
+        key.append(reinterpret_cast<const char*>(rgba), sizeof(rgba));
+        key += c->disp();
+        key += '\0';
+      } return true;
+      case Expression::BOOLEAN:
+        key += static_cast<Boolean*>(e)->value() ? 'T' : 'F';
+        return true;
+      case Expression::NULL_VAL:
+        key += 'z';
+        return true;
+      case Expression::STRING: {
+        if (typeid(*e) != typeid(String_Constant)) return false;
+        String_Constant* str = static_cast<String_Constant*>(e);
+        size_t len = str->value().length();
+        key += 's';
+        key += str->is_delayed() ? 'd' : '-';
+        key += str->needs_unquoting() ? 'u' : '-';
+        key.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        key += str->value();
+      } return true;
+      case Expression::LIST: {
+        List* l = static_cast<List*>(e);
+        size_t len = l->length();
+        // keying long lists would cost more than it's likely to save
+        if (len > MAX_KEYED_LIST_LENGTH) return false;
+        key += 'l';
+        key += l->separator() == List::COMMA ? ',' : ' ';
+        key += l->is_arglist() ? 'a' : '-';
+        key.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        for (size_t i = 0; i < len; ++i) {
+          if (!append_value_key((*l)[i], key)) return false;
+        }
+      } return true;
+      default:
+        return false;
+    }
+  }
+
+  static Function_Purity& function_purity(Definition* def, Context& ctx);
+
+  // Collects the variables a function or mixin reads and assigns; returns
+  // false if it does anything besides computing a value (or declarations)
+  // from them, or calls anything which might.
+  static bool collect_variables(AST_Node* n, Definition* def, Context& ctx, set<string>& reads, set<string>& writes)
+  {
+    if (!n) return true;
+    const type_info& t = typeid(*n);
+    if (t == typeid(Block)) {
+      Block* b = static_cast<Block*>(n);
+      for (size_t i = 0, L = b->length(); i < L; ++i) {
+        if (!collect_variables((*b)[i], def, ctx, reads, writes)) return false;
+      }
+      return true;
+    }
+    if (t == typeid(Assignment)) {
+      Assignment* a = static_cast<Assignment*>(n);
+      writes.insert(a->variable());
+      return collect_variables(a->value(), def, ctx, reads, writes);
+    }
+    if (t == typeid(If)) {
+      If* i = static_cast<If*>(n);
+      return collect_variables(i->predicate(), def, ctx, reads, writes) &&
+             collect_variables(i->consequent(), def, ctx, reads, writes) &&
+             collect_variables(i->alternative(), def, ctx, reads, writes);
+    }
+    if (t == typeid(For)) {
+      For* f = static_cast<For*>(n);
+      writes.insert(f->variable());
+      return collect_variables(f->lower_bound(), def, ctx, reads, writes) &&
+             collect_variables(f->upper_bound(), def, ctx, reads, writes) &&
+             collect_variables(f->block(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Each)) {
+      Each* e = static_cast<Each*>(n);
+      writes.insert(e->variable());
+      return collect_variables(e->list(), def, ctx, reads, writes) &&
+             collect_variables(e->block(), def, ctx, reads, writes);
+    }
+    if (t == typeid(While)) {
+      While* w = static_cast<While*>(n);
+      return collect_variables(w->predicate(), def, ctx, reads, writes) &&
+             collect_variables(w->block(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Return)) {
+      return collect_variables(static_cast<Return*>(n)->value(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Variable)) {
+      reads.insert(static_cast<Variable*>(n)->name());
+      return true;
+    }
+    if (t == typeid(Binary_Expression)) {
+      Binary_Expression* b = static_cast<Binary_Expression*>(n);
+      return collect_variables(b->left(), def, ctx, reads, writes) &&
+             collect_variables(b->right(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Unary_Expression)) {
+      return collect_variables(static_cast<Unary_Expression*>(n)->operand(), def, ctx, reads, writes);
+    }
+    if (t == typeid(List)) {
+      List* l = static_cast<List*>(n);
+      for (size_t i = 0, L = l->length(); i < L; ++i) {
+        if (!collect_variables((*l)[i], def, ctx, reads, writes)) return false;
+      }
+      return true;
+    }
+    if (t == typeid(String_Schema)) {
+      String_Schema* ss = static_cast<String_Schema*>(n);
+      for (size_t i = 0, L = ss->length(); i < L; ++i) {
+        if (!collect_variables((*ss)[i], def, ctx, reads, writes)) return false;
+      }
+      return true;
+    }
+    if (t == typeid(Arguments)) {
+      Arguments* args = static_cast<Arguments*>(n);
+      for (size_t i = 0, L = args->length(); i < L; ++i) {
+        if (!collect_variables((*args)[i]->value(), def, ctx, reads, writes)) return false;
+      }
+      return true;
+    }
+    if (t == typeid(Function_Call)) {
+      Function_Call* c = static_cast<Function_Call*>(n);
+      // the callee is resolved in the environment the function was defined in
+      string full_name(c->name() + "[f]");
+      Env* closure = def->environment();
+      if (closure && closure->has(full_name)) {
+        Definition* callee = static_cast<Definition*>((*closure)[full_name]);
+        if (callee->c_function()) return false;
+        if (callee->block() && callee != def) {
+          Function_Purity& p = function_purity(callee, ctx);
+          if (!p.pure || !p.free_variables.empty() || !p.locals.empty()) return false;
+        }
+      }
+      return collect_variables(c->arguments(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Function_Call_Schema)) {
+      Function_Call_Schema* c = static_cast<Function_Call_Schema*>(n);
+      return collect_variables(c->name(), def, ctx, reads, writes) &&
+             collect_variables(c->arguments(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Declaration)) {
+      Declaration* d = static_cast<Declaration*>(n);
+      return collect_variables(d->property(), def, ctx, reads, writes) &&
+             collect_variables(d->value(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Propset)) {
+      Propset* p = static_cast<Propset*>(n);
+      return collect_variables(p->property_fragment(), def, ctx, reads, writes) &&
+             collect_variables(p->block(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Comment)) {
+      return collect_variables(static_cast<Comment*>(n)->text(), def, ctx, reads, writes);
+    }
+    if (t == typeid(Mixin_Call)) {
+      Mixin_Call* c = static_cast<Mixin_Call*>(n);
+      if (c->block()) return false;
+      string full_name(c->name() + "[m]");
+      Env* closure = def->environment();
+      if (!closure || !closure->has(full_name)) return false;
+      Definition* callee = static_cast<Definition*>((*closure)[full_name]);
+      if (callee != def) {
+        Function_Purity& p = function_purity(callee, ctx);
+        if (!p.pure || !p.free_variables.empty() || !p.locals.empty()) return false;
+      }
+      return collect_variables(c->arguments(), def, ctx, reads, writes);
+    }
+    return t == typeid(Textual) || t == typeid(String_Constant) || t == typeid(Number) ||
+           t == typeid(Color) || t == typeid(Boolean) || t == typeid(Null);
+  }
+
+  // Works out whether a user-defined function or mixin is pure, i.e.,
+  // whether its result depends on nothing but its arguments and the values
+  // of the variables it reads from outside, and it has no other effect.
+  static Function_Purity& function_purity(Definition* def, Context& ctx)
+  {
+    map<Definition*, Function_Purity>::iterator found = ctx.function_purities.find(def);
+    if (found != ctx.function_purities.end()) return found->second;
+    Function_Purity& purity = ctx.function_purities[def];
+    purity.pure = false; // until it's known, e.g., for mutual recursion
+    set<string> reads, writes, params;
+    bool pure = true;
+    Parameters* ps = def->parameters();
+    for (size_t i = 0, L = ps ? ps->length() : 0; pure && i < L; ++i) {
+      params.insert((*ps)[i]->name());
+      pure = collect_variables((*ps)[i]->default_value(), def, ctx, reads, writes);
+    }
+    pure = pure && collect_variables(def->block(), def, ctx, reads, writes);
+    for (set<string>::iterator i = reads.begin(); i != reads.end(); ++i) {
+      if (!params.count(*i) && !writes.count(*i)) purity.free_variables.push_back(*i);
+    }
+    for (set<string>::iterator i = writes.begin(); i != writes.end(); ++i) {
+      if (!params.count(*i)) purity.locals.push_back(*i);
+    }
+    purity.pure = pure;
+    return purity;
+  }
+
+  // Builds the key of a call to `def` with the evaluated `args` in the
+  // memo of function or mixin results; returns false if the call can't be
+  // memoized.
+  bool call_key(Definition* def, Arguments* args, Context& ctx, string& key)
+  {
+    if (def->c_function()) return false;
+    if (!def->block() && !is_pure_built_in(def->name())) return false;
+    if (def->block()) {
+      Function_Purity& purity = function_purity(def, ctx);
+      if (!purity.pure) return false;
+      Env* closure = def->environment();
+      // assigning a variable which exists outside would change it
+      for (size_t i = 0, L = purity.locals.size(); i < L; ++i) {
+        if (closure->has(purity.locals[i])) return false;
+      }
+      for (size_t i = 0, L = purity.free_variables.size(); i < L; ++i) {
+        if (!closure->has(purity.free_variables[i])) return false;
+        AST_Node* value = (*closure)[purity.free_variables[i]];
+        if (typeid(*value) == typeid(Argument)) value = static_cast<Argument*>(value)->value();
+        if (!append_value_key(static_cast<Expression*>(value), key)) return false;
+      }
+    }
+    for (size_t i = 0, L = args->length(); i < L; ++i) {
+      Argument* arg = (*args)[i];
+      key += arg->is_rest_argument() ? '*' : '$';
+      key += arg->name();
+      key += '\0';
+      if (!append_value_key(arg->value(), key)) return false;
+    }
+    return true;
+  }
+
   Eval::Eval(Context& ctx, Env* env, Backtrace* bt)
   : ctx(ctx), env(env), backtrace(bt) { }
   Eval::~Eval() { }
@@ -78,24 +384,26 @@ namespace Sass {
     string variable(f->variable());
     Expression* low = f->lower_bound()->perform(this);
     if (low->concrete_type() != Expression::NUMBER) {
+      low = ctx.unshare(low, f->path(), f->position());
       error("lower bound of `@for` directive must be numeric", low->path(), low->position());
     }
     Expression* high = f->upper_bound()->perform(this);
     if (high->concrete_type() != Expression::NUMBER) {
+      high = ctx.unshare(high, f->path(), f->position());
       error("upper bound of `@for` directive must be numeric", high->path(), high->position());
     }
     double lo = static_cast<Number*>(low)->value();
     double hi = static_cast<Number*>(high)->value();
     if (f->is_inclusive()) ++hi;
     Env new_env;
-    new_env[variable] = new (ctx.mem) Number(low->path(), low->position(), lo);
+    new_env[variable] = ctx.unitless_number(low->path(), low->position(), lo);
     new_env.link(env);
     env = &new_env;
     Block* body = f->block();
     Expression* val = 0;
     for (double i = lo;
          i < hi;
-         (*env)[variable] = new (ctx.mem) Number(low->path(), low->position(), ++i)) {
+         (*env)[variable] = ctx.unitless_number(low->path(), low->position(), ++i)) {
       val = body->perform(this);
       if (val) break;
     }
@@ -153,20 +461,55 @@ namespace Sass {
     string prefix("WARNING: ");
     string result(unquote(message->perform(&to_string)));
     cerr << prefix << result;
-    Backtrace top(backtrace, w->path(), w->position(), "");
+    Backtrace top(backtrace, &w->path(), w->position());
     cerr << top.to_string(true);
     cerr << endl << endl;
     return 0;
   }
 
+  // whether evaluating `e` gives `e` itself, whenever it's evaluated
+  static bool evaluates_to_itself(Context& ctx, Expression* e)
+  {
+    const type_info& t = typeid(*e);
+    if (t == typeid(Number) || t == typeid(Boolean) || t == typeid(Null) || t == typeid(Color)) {
+      return true;
+    }
+    if (t == typeid(String_Constant)) {
+      return !ctx.names_to_colors.count(static_cast<String_Constant*>(e)->value());
+    }
+    return false;
+  }
+
   Expression* Eval::operator()(List* l)
   {
+    // share the elements unless evaluating one of them gives something else
+    size_t i = l->settled(), L = l->length();
+    Expression* evaluated = 0;
+    for (; i < L; ++i) {
+      if (i == l->settled() && evaluates_to_itself(ctx, (*l)[i])) {
+        l->settled(i + 1);
+        continue;
+      }
+      evaluated = (*l)[i]->perform(this);
+      if (evaluated != (*l)[i]) break;
+    }
+    if (i == L) {
+      List* ll = new (ctx.mem) List(l->path(),
+                                    l->position(),
+                                    0,
+                                    l->separator(),
+                                    l->is_arglist());
+      *ll += l;
+      return ll;
+    }
     List* ll = new (ctx.mem) List(l->path(),
                                   l->position(),
-                                  l->length(),
+                                  L,
                                   l->separator(),
                                   l->is_arglist());
-    for (size_t i = 0, L = l->length(); i < L; ++i) {
+    for (size_t j = 0; j < i; ++j) *ll << (*l)[j];
+    *ll << evaluated;
+    for (++i; i < L; ++i) {
       *ll << (*l)[i]->perform(this);
     }
     return ll;
@@ -175,8 +518,9 @@ namespace Sass {
   // -- only need to define two comparisons, and the rest can be implemented in terms of them
   bool eq(Expression*, Expression*, Context&, Eval*);
   bool lt(Expression*, Expression*, Context&);
+  int compare(Expression*, Expression*, Context&, Binary_Expression*);
   // -- arithmetic on the combinations that matter
-  Expression* op_numbers(Context&, Binary_Expression*, Expression*, Expression*);
+  Expression* op_numbers(Context&, Binary_Expression*, Expression*, Expression*, Number*);
   Expression* op_number_color(Context&, Binary_Expression::Type, Expression*, Expression*);
   Expression* op_color_number(Context&, Binary_Expression::Type, Expression*, Expression*);
   Expression* op_colors(Context&, Binary_Expression::Type, Expression*, Expression*);
@@ -184,9 +528,64 @@ namespace Sass {
 
   Expression* Eval::operator()(Binary_Expression* b)
   {
-    Binary_Expression::Type op_type = b->type();
     // don't eval delayed expressions (the '/' when used as a separator)
-    if (op_type == Binary_Expression::DIV && b->is_delayed()) return b;
+    if (b->type() == Binary_Expression::DIV && b->is_delayed()) return b;
+    if (b->folded()) return copy_constant(ctx, b->folded());
+    Expression* result = operate(b);
+    if (is_constant(b->left()) && is_constant(b->right())) {
+      b->folded(copy_constant(ctx, result));
+    }
+    return result;
+  }
+
+  // source maps point a value at where it was computed, which a shared one
+  // can't be, so the results get their own booleans while making them
+  static Expression* truth(Context& ctx, Binary_Expression* b, bool value)
+  {
+    if (ctx.source_maps) return new (ctx.mem) Boolean(b->path(), b->position(), value);
+    return value ? ctx.true_value : ctx.false_value;
+  }
+
+  // Comparisons don't modify their operands, so literals can be compared
+  // as they are, without being copied first.
+  static bool is_relational(Binary_Expression::Type op)
+  { return op >= Binary_Expression::EQ && op <= Binary_Expression::LTE; }
+
+  // whether evaluating `e` always makes a new number, which nothing else
+  // refers to and which may be reused for the result of an operation on it
+  static bool makes_new_number(Context& ctx, Expression* e, Expression* value)
+  {
+    if (value->concrete_type() != Expression::NUMBER || ctx.is_shared(value)) return false;
+    const type_info& t = typeid(*e);
+    if (t == typeid(Textual) || t == typeid(Unary_Expression)) return true;
+    if (t == typeid(Binary_Expression)) {
+      Binary_Expression::Type op = static_cast<Binary_Expression*>(e)->type();
+      return op >= Binary_Expression::ADD && op <= Binary_Expression::MOD;
+    }
+    return false;
+  }
+
+  Expression* Eval::operate(Binary_Expression* b)
+  {
+    Binary_Expression::Type op_type = b->type();
+    if (is_relational(op_type)) {
+      Expression* left  = b->left();
+      Expression* right = b->right();
+      Expression* lhs = typeid(*left) == typeid(Textual)
+                      ? static_cast<Textual*>(left)->literal()
+                      : left->perform(this);
+      Expression* rhs = typeid(*right) == typeid(Textual)
+                      ? static_cast<Textual*>(right)->literal()
+                      : right->perform(this);
+      switch(op_type) {
+        case Binary_Expression::EQ:  return truth(ctx, b, eq(lhs, rhs, ctx));
+        case Binary_Expression::NEQ: return truth(ctx, b, !eq(lhs, rhs, ctx));
+        case Binary_Expression::GT:  return truth(ctx, b, compare(lhs, rhs, ctx, b) > 0);
+        case Binary_Expression::GTE: return truth(ctx, b, compare(lhs, rhs, ctx, b) >= 0);
+        case Binary_Expression::LT:  return truth(ctx, b, compare(lhs, rhs, ctx, b) < 0);
+        default:                     return truth(ctx, b, compare(lhs, rhs, ctx, b) <= 0);
+      }
+    }
     // the logical connectives need to short-circuit
     Expression* lhs = b->left()->perform(this);
     switch (op_type) {
@@ -204,24 +603,18 @@ namespace Sass {
     // not a logical connective, so go ahead and eval the rhs
     Expression* rhs = b->right()->perform(this);
 
-    // see if it's a relational expression
-    switch(op_type) {
-      case Binary_Expression::EQ:  return new (ctx.mem) Boolean(b->path(), b->position(), eq(lhs, rhs, ctx));
-      case Binary_Expression::NEQ: return new (ctx.mem) Boolean(b->path(), b->position(), !eq(lhs, rhs, ctx));
-      case Binary_Expression::GT:  return new (ctx.mem) Boolean(b->path(), b->position(), !lt(lhs, rhs, ctx) && !eq(lhs, rhs, ctx));
-      case Binary_Expression::GTE: return new (ctx.mem) Boolean(b->path(), b->position(), !lt(lhs, rhs, ctx));
-      case Binary_Expression::LT:  return new (ctx.mem) Boolean(b->path(), b->position(), lt(lhs, rhs, ctx));
-      case Binary_Expression::LTE: return new (ctx.mem) Boolean(b->path(), b->position(), lt(lhs, rhs, ctx) || eq(lhs, rhs, ctx));
-
-      default:                     break;
-    }
-
     Expression::Concrete_Type l_type = lhs->concrete_type();
     Expression::Concrete_Type r_type = rhs->concrete_type();
 
     if (l_type == Expression::NUMBER && r_type == Expression::NUMBER) {
-      return op_numbers(ctx, b, lhs, rhs);
+      Number* scratch = 0;
+      if      (makes_new_number(ctx, b->left(), lhs))  scratch = static_cast<Number*>(lhs);
+      else if (makes_new_number(ctx, b->right(), rhs)) scratch = static_cast<Number*>(rhs);
+      return op_numbers(ctx, b, lhs, rhs, scratch);
     }
+    // errors are reported at the operands, which shared values can't be
+    lhs = ctx.unshare(lhs, b->path(), b->position());
+    rhs = ctx.unshare(rhs, b->path(), b->position());
     if (l_type == Expression::NUMBER && r_type == Expression::COLOR) {
       return op_number_color(ctx, op_type, lhs, rhs);
     }
@@ -235,10 +628,22 @@ namespace Sass {
   }
 
   Expression* Eval::operator()(Unary_Expression* u)
+  {
+    if (u->folded()) return copy_constant(ctx, u->folded());
+    Expression* result = operate(u);
+    if (is_constant(u->operand())) u->folded(copy_constant(ctx, result));
+    return result;
+  }
+
+  Expression* Eval::operate(Unary_Expression* u)
   {
     Expression* operand = u->operand()->perform(this);
     if (operand->concrete_type() == Expression::NUMBER) {
       Number* result = new (ctx.mem) Number(*static_cast<Number*>(operand));
+      if (ctx.is_shared(operand)) {
+        result->path(u->path());
+        result->position(u->position());
+      }
       result->value(u->type() == Unary_Expression::MINUS
                     ? -result->value()
                     :  result->value());
@@ -260,13 +665,30 @@ namespace Sass {
     return u;
   }
 
+  Definition* Eval::function_definition(Function_Call* c)
+  {
+    if (c->resolved_version() == ctx.definitions_version && !ctx.has_local_definitions) {
+      return c->resolved_definition();
+    }
+    string full_name(c->name() + "[f]");
+    Definition* def = env->has(full_name) ? static_cast<Definition*>((*env)[full_name]) : 0;
+    c->resolved_definition(def);
+    c->resolved_version(ctx.definitions_version);
+    c->resolved_overload(0);
+    return def;
+  }
+
   Expression* Eval::operator()(Function_Call* c)
   {
+    Definition* def = function_definition(c);
+    // a call folded earlier is still good unless the function was redefined
+    if (c->folded() && def == c->folded_by()) {
+      return copy_constant(ctx, c->folded());
+    }
     Arguments* args = static_cast<Arguments*>(c->arguments()->perform(this));
-    string full_name(c->name() + "[f]");
 
     // if it doesn't exist, just pass it through as a literal
-    if (!env->has(full_name)) {
+    if (!def) {
       Function_Call* lit = new (ctx.mem) Function_Call(c->path(),
                                                        c->position(),
                                                        c->name(),
@@ -278,7 +700,6 @@ namespace Sass {
     }
 
     Expression*     result = c;
-    Definition*     def    = static_cast<Definition*>((*env)[full_name]);
     Block*          body   = def->block();
     Native_Function func   = def->native_function();
     Sass_C_Function c_func = def->c_function();
@@ -287,6 +708,15 @@ namespace Sass {
       (*args)[i]->value((*args)[i]->value()->perform(this));
     }
 
+    // pure functions called with the same arguments again return the same
+    string memo_key;
+    bool memoize = call_key(def, args, ctx, memo_key);
+    Expression* memoized = 0;
+    if (memoize) {
+      map<pair<Definition*, string>, Expression*>::iterator hit = ctx.function_results.find(make_pair(def, memo_key));
+      if (hit != ctx.function_results.end()) memoized = hit->second;
+    }
+
     Parameters* params = def->parameters();
     Env new_env;
     new_env.link(def->environment());
@@ -297,14 +727,17 @@ namespace Sass {
     // Backtrace here(backtrace, c->path(), c->line(), ", in function `" + c->name() + "`");
     // backtrace = &here;
 
+    if (memoized) {
+      result = copy_constant(ctx, memoized);
+    }
     // if it's user-defined, eval the body
-    if (body) {
+    else if (body) {
 
       bind("function " + c->name(), params, args, ctx, &new_env, this);
       Env* old_env = env;
       env = &new_env;
 
-      Backtrace here(backtrace, c->path(), c->position(), ", in function `" + c->name() + "`");
+      Backtrace here(backtrace, &c->path(), c->position(), "function", &c->name());
       backtrace = &here;
 
       result = body->perform(this);
@@ -321,7 +754,7 @@ namespace Sass {
       Env* old_env = env;
       env = &new_env;
 
-      Backtrace here(backtrace, c->path(), c->position(), ", in function `" + c->name() + "`");
+      Backtrace here(backtrace, &c->path(), c->position(), "function", &c->name());
       backtrace = &here;
 
       result = func(*env, ctx, def->signature(), c->path(), c->position(), backtrace);
@@ -336,7 +769,7 @@ namespace Sass {
       Env* old_env = env;
       env = &new_env;
 
-      Backtrace here(backtrace, c->path(), c->position(), ", in function `" + c->name() + "`");
+      Backtrace here(backtrace, &c->path(), c->position(), "function", &c->name());
       backtrace = &here;
 
       To_C to_c;
@@ -352,11 +785,16 @@ namespace Sass {
     // else it's an overloaded native function; resolve it
     else if (def->is_overload_stub()) {
       size_t arity = args->length();
-      stringstream ss;
-      ss << full_name << arity;
-      string resolved_name(ss.str());
-      if (!env->has(resolved_name)) error("overloaded function `" + string(c->name()) + "` given wrong number of arguments", c->path(), c->position());
-      Definition* resolved_def = static_cast<Definition*>((*env)[resolved_name]);
+      Definition* resolved_def = c->resolved_overload();
+      if (!resolved_def || c->resolved_arity() != arity || ctx.has_local_definitions) {
+        stringstream ss;
+        ss << c->name() << "[f]" << arity;
+        string resolved_name(ss.str());
+        if (!env->has(resolved_name)) error("overloaded function `" + string(c->name()) + "` given wrong number of arguments", c->path(), c->position());
+        resolved_def = static_cast<Definition*>((*env)[resolved_name]);
+        c->resolved_overload(resolved_def);
+        c->resolved_arity(arity);
+      }
       params = resolved_def->parameters();
       Env newer_env;
       newer_env.link(resolved_def->environment());
@@ -364,7 +802,7 @@ namespace Sass {
       Env* old_env = env;
       env = &newer_env;
 
-      Backtrace here(backtrace, c->path(), c->position(), ", in function `" + c->name() + "`");
+      Backtrace here(backtrace, &c->path(), c->position(), "function", &c->name());
       backtrace = &here;
 
       result = resolved_def->native_function()(*env, ctx, resolved_def->signature(), c->path(), c->position(), backtrace);
@@ -375,7 +813,24 @@ namespace Sass {
 
     // backtrace = here.parent;
     // env = old_env;
+    result = ctx.unshare(result, c->path(), c->position());
     result->position(c->position());
+    if (memoize && !memoized) {
+      Expression* copy = copy_constant(ctx, result);
+      if (copy) ctx.function_results[make_pair(def, memo_key)] = copy;
+    }
+
+    if ((func || def->is_overload_stub()) && is_pure_built_in(c->name())) {
+      Arguments* c_args = c->arguments();
+      bool constant = true;
+      for (size_t i = 0, L = c_args->length(); constant && i < L; ++i) {
+        constant = is_constant((*c_args)[i]->value());
+      }
+      if (constant) {
+        c->folded(copy_constant(ctx, result));
+        c->folded_by(def);
+      }
+    }
     return result;
   }
 
@@ -403,53 +858,13 @@ namespace Sass {
 
   Expression* Eval::operator()(Textual* t)
   {
-    using Prelexer::number;
-    Expression* result = 0;
-    switch (t->type())
-    {
-      case Textual::NUMBER:
-        result = new (ctx.mem) Number(t->path(),
-                                      t->position(),
-                                      atof(t->value().c_str()));
-        break;
-      case Textual::PERCENTAGE:
-        result = new (ctx.mem) Number(t->path(),
-                                      t->position(),
-                                      atof(t->value().c_str()),
-                                      "%");
-        break;
-      case Textual::DIMENSION:
-        result = new (ctx.mem) Number(t->path(),
-                                      t->position(),
-                                      atof(t->value().c_str()),
-                                      Token(number(t->value().c_str())));
-        break;
-      case Textual::HEX: {
-        string hext(t->value().substr(1)); // chop off the '#'
-        if (hext.length() == 6) {
-          string r(hext.substr(0,2));
-          string g(hext.substr(2,2));
-          string b(hext.substr(4,2));
-          result = new (ctx.mem) Color(t->path(),
-                                       t->position(),
-                                       static_cast<double>(strtol(r.c_str(), NULL, 16)),
-                                       static_cast<double>(strtol(g.c_str(), NULL, 16)),
-                                       static_cast<double>(strtol(b.c_str(), NULL, 16)),
-                                       1,
-                                       t->value());
-        }
-        else {
-          result = new (ctx.mem) Color(t->path(),
-                                       t->position(),
-                                       static_cast<double>(strtol(string(2,hext[0]).c_str(), NULL, 16)),
-                                       static_cast<double>(strtol(string(2,hext[1]).c_str(), NULL, 16)),
-                                       static_cast<double>(strtol(string(2,hext[2]).c_str(), NULL, 16)),
-                                       1,
-                                       t->value());
-        }
-      } break;
+    // the literal was decoded by the parser; hand out a copy of it, since
+    // evaluated values may be modified afterwards
+    Expression* lit = t->literal();
+    if (t->type() == Textual::HEX) {
+      return new (ctx.mem) Color(*static_cast<Color*>(lit));
     }
-    return result;
+    return new (ctx.mem) Number(*static_cast<Number*>(lit));
   }
 
   Expression* Eval::operator()(Number* n)
@@ -575,6 +990,15 @@ namespace Sass {
 
   // All the binary helpers.
 
+  // Numbers with the same simple unit (or none) can be compared and added
+  // as they are, without being normalized first.
+  static bool same_units(Number* l, Number* r)
+  {
+    return l->denominator_units().empty() && r->denominator_units().empty() &&
+           l->numerator_units().size() <= 1 &&
+           l->numerator_units() == r->numerator_units();
+  }
+
   bool eq(Expression* lhs, Expression* rhs, Context& ctx)
   {
     Expression::Concrete_Type ltype = lhs->concrete_type();
@@ -590,6 +1014,7 @@ namespace Sass {
       case Expression::NUMBER: {
         Number* l = static_cast<Number*>(lhs);
         Number* r = static_cast<Number*>(rhs);
+        if (same_units(l, r)) return l->value() == r->value();
         Number tmp_r(*r);
         tmp_r.normalize(l->find_convertible_unit());
         return l->unit() == tmp_r.unit() && l->value() == tmp_r.value()
@@ -638,6 +1063,7 @@ namespace Sass {
       error("may only compare numbers", lhs->path(), lhs->position());
     Number* l = static_cast<Number*>(lhs);
     Number* r = static_cast<Number*>(rhs);
+    if (same_units(l, r)) return l->value() < r->value();
     Number tmp_r(*r);
     tmp_r.normalize(l->find_convertible_unit());
     string l_unit(l->unit());
@@ -648,29 +1074,71 @@ namespace Sass {
     return l->value() < tmp_r.value();
   }
 
-  Expression* op_numbers(Context& ctx, Binary_Expression* b, Expression* lhs, Expression* rhs)
+  // three-way comparison for the ordering operators: negative if lhs < rhs,
+  // zero if they're equal, and positive otherwise
+  int compare(Expression* lhs, Expression* rhs, Context& ctx, Binary_Expression* b)
+  {
+    if (lhs->concrete_type() == Expression::NUMBER &&
+        rhs->concrete_type() == Expression::NUMBER) {
+      Number* l = static_cast<Number*>(lhs);
+      Number* r = static_cast<Number*>(rhs);
+      if (same_units(l, r)) {
+        return l->value() < r->value() ? -1 : l->value() == r->value() ? 0 : 1;
+      }
+    }
+    // errors are reported at the operands, which shared values can't be
+    lhs = ctx.unshare(lhs, b->path(), b->position());
+    rhs = ctx.unshare(rhs, b->path(), b->position());
+    if (lt(lhs, rhs, ctx)) return -1;
+    return eq(lhs, rhs, ctx) ? 0 : 1;
+  }
+
+  // `scratch` is a number which may hold the result instead of a new one,
+  // if it's not 0
+  Expression* op_numbers(Context& ctx, Binary_Expression* b, Expression* lhs, Expression* rhs, Number* scratch)
   {
     Number* l = static_cast<Number*>(lhs);
     Number* r = static_cast<Number*>(rhs);
     double lv = l->value();
     double rv = r->value();
     Binary_Expression::Type op = b->type();
+    // a shared operand has no path of its own to give the result
+    const string& path(ctx.is_shared(l) ? b->path() : l->path());
     if (op == Binary_Expression::DIV && !rv) {
-      return new (ctx.mem) String_Constant(l->path(), b->position(), "Infinity");
+      return new (ctx.mem) String_Constant(path, b->position(), "Infinity");
     }
     if (op == Binary_Expression::MOD && !rv) {
+      r = static_cast<Number*>(ctx.unshare(r, b->path(), b->position()));
       error("division by zero", r->path(), r->position());
     }
 
+    // the result has the left operand's unit, and needs no normalizing
+    if (same_units(l, r) ? op != Binary_Expression::MUL && op != Binary_Expression::DIV
+                         : r->is_unitless() && l->numerator_units().size() <= 1 && l->denominator_units().empty()) {
+      Number* v = scratch;
+      if (!v) {
+        v = new (ctx.mem) Number(*l);
+      }
+      else if (v != l) {
+        v->numerator_units() = l->numerator_units();
+      }
+      v->path(path);
+      v->position(b->position());
+      v->value(ops[op](lv, rv));
+      return v;
+    }
+
     Number tmp(*r);
     tmp.normalize(l->find_convertible_unit());
     string l_unit(l->unit());
     string r_unit(tmp.unit());
     if (l_unit != r_unit && !l_unit.empty() && !r_unit.empty() &&
         (op == Binary_Expression::ADD || op == Binary_Expression::SUB)) {
+      l = static_cast<Number*>(ctx.unshare(l, b->path(), b->position()));
       error("cannot add or subtract numbers with incompatible units", l->path(), l->position());
     }
     Number* v = new (ctx.mem) Number(*l);
+    v->path(path);
     v->position(b->position());
     if (l_unit.empty() && (op == Binary_Expression::ADD || op == Binary_Expression::SUB)) {
       v->numerator_units() = r->numerator_units();
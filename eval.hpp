@@ -31,6 +31,10 @@ namespace Sass {
 
     Expression* fallback_impl(AST_Node* n);
 
+    Expression* operate(Binary_Expression*);
+    Expression* operate(Unary_Expression*);
+    Definition* function_definition(Function_Call*);
+
   public:
     Env*       env;
     Backtrace* backtrace;
@@ -74,4 +78,6 @@ namespace Sass {
 
   bool eq(Expression*, Expression*, Context&);
   bool lt(Expression*, Expression*, Context&);
+
+  bool call_key(Definition*, Arguments*, Context&, string&);
 }
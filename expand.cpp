@@ -21,6 +21,7 @@ namespace Sass {
     eval(eval),
     contextualize(contextualize),
     env(env),
+    root_env(0),
     block_stack(vector<Block*>()),
     property_stack(vector<String*>()),
     selector_stack(vector<Selector*>()),
@@ -32,6 +33,7 @@ namespace Sass {
     Env new_env;
     new_env.link(*env);
     env = &new_env;
+    if (b->is_root()) root_env = env;
     Block* bb = new (ctx.mem) Block(b->path(), b->position(), b->length(), b->is_root());
     block_stack.push_back(bb);
     append_block(b);
@@ -46,7 +48,7 @@ namespace Sass {
     // if (selector_stack.back()) cerr << "expanding " << selector_stack.back()->perform(&to_string) << " and " << r->selector()->perform(&to_string) << endl;
     Selector* sel_ctx = r->selector()->perform(contextualize->with(selector_stack.back(), env, backtrace));
     // re-parse in order to restructure parent nodes correctly
-    sel_ctx = Parser::from_c_str((sel_ctx->perform(&to_string) + ";").c_str(), ctx, r->selector()->path(), r->selector()->position()).parse_selector_group();
+    sel_ctx = Parser::from_c_str(ctx.add_text(sel_ctx->perform(&to_string) + ";"), ctx, r->selector()->path(), r->selector()->position()).parse_selector_group();
     selector_stack.push_back(sel_ctx);
     Ruleset* rr = new (ctx.mem) Ruleset(r->path(),
                                         r->position(),
@@ -122,10 +124,14 @@ namespace Sass {
   {
     String* old_p = d->property();
     String* new_p = static_cast<String*>(old_p->perform(eval->with(env, backtrace)));
+    Expression* value = d->value()->perform(eval->with(env, backtrace));
+    // the value is mapped to the source by its position, which a shared one
+    // doesn't have
+    value = ctx.unshare(value, d->value()->path(), d->value()->position());
     return new (ctx.mem) Declaration(d->path(),
                                      d->position(),
                                      new_p,
-                                     d->value()->perform(eval->with(env, backtrace)),
+                                     value,
                                      d->is_important());
   }
 
@@ -186,23 +192,25 @@ namespace Sass {
     string variable(f->variable());
     Expression* low = f->lower_bound()->perform(eval->with(env, backtrace));
     if (low->concrete_type() != Expression::NUMBER) {
+      low = ctx.unshare(low, f->path(), f->position());
       error("lower bound of `@for` directive must be numeric", low->path(), low->position(), backtrace);
     }
     Expression* high = f->upper_bound()->perform(eval->with(env, backtrace));
     if (high->concrete_type() != Expression::NUMBER) {
+      high = ctx.unshare(high, f->path(), f->position());
       error("upper bound of `@for` directive must be numeric", high->path(), high->position(), backtrace);
     }
     double lo = static_cast<Number*>(low)->value();
     double hi = static_cast<Number*>(high)->value();
     if (f->is_inclusive()) ++hi;
     Env new_env;
-    new_env[variable] = new (ctx.mem) Number(low->path(), low->position(), lo);
+    new_env[variable] = ctx.unitless_number(low->path(), low->position(), lo);
     new_env.link(env);
     env = &new_env;
     Block* body = f->block();
     for (double i = lo;
          i < hi;
-         (*env)[variable] = new (ctx.mem) Number(low->path(), low->position(), ++i)) {
+         (*env)[variable] = ctx.unitless_number(low->path(), low->position(), ++i)) {
       append_block(body);
     }
     env = new_env.parent();
@@ -284,6 +292,12 @@ namespace Sass {
     Definition* dd = new (ctx.mem) Definition(*d);
     env->current_frame()[d->name() +
                         (d->type() == Definition::MIXIN ? "[m]" : "[f]")] = dd;
+    ++ctx.definitions_version;
+    if (env != root_env) ctx.has_local_definitions = true;
+    // calls may resolve to another definition from now on
+    ctx.function_purities.clear();
+    ctx.mixin_results.clear();
+    if (d->type() == Definition::FUNCTION) ctx.function_results.clear();
     // set the static link so we can have lexical scoping
     dd->environment(env);
     return 0;
@@ -291,16 +305,46 @@ namespace Sass {
 
   Statement* Expand::operator()(Mixin_Call* c)
   {
-    string full_name(c->name() + "[m]");
-    if (!env->has(full_name)) {
-      error("no mixin named " + c->name(), c->path(), c->position(), backtrace);
+    Definition* def = c->resolved_definition();
+    if (c->resolved_version() != ctx.definitions_version || ctx.has_local_definitions) {
+      string full_name(c->name() + "[m]");
+      if (!env->has(full_name)) {
+        error("no mixin named " + c->name(), c->path(), c->position(), backtrace);
+      }
+      def = static_cast<Definition*>((*env)[full_name]);
+      c->resolved_definition(def);
+      c->resolved_version(ctx.definitions_version);
     }
-    Definition* def = static_cast<Definition*>((*env)[full_name]);
     Block* body = def->block();
     Parameters* params = def->parameters();
     Arguments* args = static_cast<Arguments*>(c->arguments()
                                                ->perform(eval->with(env, backtrace)));
-    Backtrace here(backtrace, c->path(), c->position(), ", in mixin `" + c->name() + "`");
+
+    // a pure mixin included with the same arguments again expands to the
+    // same declarations; they're copied, since a property set around the
+    // include rewrites their properties. Source maps record where values
+    // came from, which differs between includes, so they do without. (A
+    // content block is a new definition every time, so it's never repeated.)
+    string memo_key;
+    bool memoize = !c->block() && c->name() != "@content" && !ctx.source_maps &&
+                   call_key(def, args, ctx, memo_key);
+    if (memoize) {
+      map<pair<Definition*, string>, vector<Statement*> >::iterator hit = ctx.mixin_results.find(make_pair(def, memo_key));
+      if (hit != ctx.mixin_results.end()) {
+        Block* current_block = block_stack.back();
+        vector<Statement*>& expanded = hit->second;
+        for (size_t i = 0, L = expanded.size(); i < L; ++i) {
+          Statement* stm = expanded[i];
+          if (typeid(*stm) == typeid(Declaration)) {
+            stm = new (ctx.mem) Declaration(*static_cast<Declaration*>(stm));
+          }
+          *current_block << stm;
+        }
+        return 0;
+      }
+    }
+
+    Backtrace here(backtrace, &c->path(), c->position(), "mixin", &c->name());
     backtrace = &here;
     Env new_env;
     new_env.link(def->environment());
@@ -318,9 +362,21 @@ namespace Sass {
     bind("mixin " + c->name(), params, args, ctx, &new_env, eval);
     Env* old_env = env;
     env = &new_env;
+    Block* current_block = block_stack.back();
+    size_t first = current_block->length();
     append_block(body);
     env = old_env;
     backtrace = here.parent;
+    if (memoize) {
+      vector<Statement*>& expanded = ctx.mixin_results[make_pair(def, memo_key)];
+      for (size_t i = first, L = current_block->length(); i < L; ++i) {
+        Statement* stm = (*current_block)[i];
+        if (typeid(*stm) == typeid(Declaration)) {
+          stm = new (ctx.mem) Declaration(*static_cast<Declaration*>(stm));
+        }
+        expanded.push_back(stm);
+      }
+    }
     return 0;
   }
 
@@ -31,6 +31,7 @@ namespace Sass {
     Eval*             eval;
     Contextualize*    contextualize;
     Env*              env;
+    Env*              root_env;
     vector<Block*>    block_stack;
     vector<String*>   property_stack;
     vector<Selector*> selector_stack;
@@ -83,7 +83,7 @@ namespace Sass {
       // re-parse in order to restructure expanded placeholder nodes correctly
       r->selector(
         Parser::from_c_str(
-          (all_subbed->perform(&to_string) + ";").c_str(),
+          ctx.add_text(all_subbed->perform(&to_string) + ";"),
           ctx,
           all_subbed->path(),
           all_subbed->position()
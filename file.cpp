@@ -5,13 +5,42 @@
 #include <iostream>
 #include <fstream>
 #include <cctype>
+#include <cstring>
 #include <algorithm>
+#include <map>
 #include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 #include "file.hpp"
 #include "context.hpp"
 #include "sass2scss/sass2scss.h"
 
 namespace Sass {
+  char* Source_Cache::find(const string& path, long long mtime, long long size, unsigned long long* hash) const
+  {
+    map<string, Source>::const_iterator hit = sources.find(path);
+    if (hit == sources.end() || hit->second.mtime != mtime || hit->second.size != size) return 0;
+    if (hash) *hash = hit->second.hash;
+    char* contents = new char[hit->second.contents.size() + 1];
+    memcpy(contents, hit->second.contents.c_str(), hit->second.contents.size() + 1);
+    return contents;
+  }
+
+  void Source_Cache::store(const string& path, const char* contents, unsigned long long hash, long long mtime, long long size)
+  {
+    Source& source = sources[path];
+    source.contents = contents;
+    source.hash = hash;
+    source.mtime = mtime;
+    source.size = size;
+  }
+
+  void Source_Cache::forget(const string& path)
+  { sources.erase(path); }
+
   namespace File {
     using namespace std;
 
@@ -114,7 +143,7 @@ namespace Sass {
       return result;
     }
 
-    char* resolve_and_load(string path, string& real_path)
+    char* resolve_and_load(string path, string& real_path, unsigned long long* hash, Source_Cache* cache)
     {
       // Resolution order for ambiguous imports:
       // (1) filename as given
@@ -124,29 +153,29 @@ namespace Sass {
       char* contents = 0;
       real_path = path;
       // if the file isn't found with the given filename ...
-      if (!(contents = read_file(real_path))) {
+      if (!(contents = read_file(real_path, hash, cache))) {
         string dir(dir_name(path));
         string base(base_name(path));
         string _base("_" + base);
         real_path = dir + _base;
         // if the file isn't found with '_' + filename ...
-        if (!(contents = read_file(real_path))) {
+        if (!(contents = read_file(real_path, hash, cache))) {
           string _base_scss(_base + ".scss");
           real_path = dir + _base_scss;
           // if the file isn't found with '_' + filename + ".scss" ...
-          if (!(contents = read_file(real_path))) {
+          if (!(contents = read_file(real_path, hash, cache))) {
             string _base_sass(_base + ".sass");
             real_path = dir + _base_sass;
             // if the file isn't found with '_' + filename + ".sass" ...
-            if (!(contents = read_file(real_path))) {
+            if (!(contents = read_file(real_path, hash, cache))) {
               string base_scss(base + ".scss");
               real_path = dir + base_scss;
               // if the file isn't found with filename + ".scss" ...
-              if (!(contents = read_file(real_path))) {
+              if (!(contents = read_file(real_path, hash, cache))) {
                 string base_sass(base + ".sass");
                 real_path = dir + base_sass;
                 // if the file isn't found with filename + ".sass" ...
-                if (!(contents = read_file(real_path))) {
+                if (!(contents = read_file(real_path, hash, cache))) {
                   // default back to scss version
                   real_path = dir + base_scss;
                 }
@@ -164,10 +193,106 @@ namespace Sass {
       return contents;
     }
 
-    char* read_file(string path)
+    // Indented-syntax sources converted to SCSS, shared by every compile
+    // in the process and keyed by a hash of the indented source (the one
+    // the import graph records for the file), so that partials imported
+    // over and over aren't converted again until they change.  It's
+    // dropped as a whole once it holds too much text.
+    namespace {
+      struct Converted_Source {
+        string source;
+        string converted;
+      };
+
+      const size_t converted_sources_limit = 16 * 1024 * 1024;
+
+      map<unsigned long long, Converted_Source> converted_sources;
+      size_t converted_sources_size = 0;
+
+      // compiles may run in parallel threads (see sass.compile_many())
+      struct Cache_Lock {
+      #ifdef _WIN32
+        CRITICAL_SECTION cs;
+        Cache_Lock()  { InitializeCriticalSection(&cs); }
+        ~Cache_Lock() { DeleteCriticalSection(&cs); }
+        void acquire() { EnterCriticalSection(&cs); }
+        void release() { LeaveCriticalSection(&cs); }
+      #else
+        pthread_mutex_t mutex;
+        Cache_Lock()  { pthread_mutex_init(&mutex, 0); }
+        ~Cache_Lock() { pthread_mutex_destroy(&mutex); }
+        void acquire() { pthread_mutex_lock(&mutex); }
+        void release() { pthread_mutex_unlock(&mutex); }
+      #endif
+      } converted_sources_lock;
+
+      struct Cache_Guard {
+        Cache_Guard()  { converted_sources_lock.acquire(); }
+        ~Cache_Guard() { converted_sources_lock.release(); }
+      };
+
+      char* copy_to_c_str(const string& str)
+      {
+        char* c_str = new char[str.size() + 1];
+        memcpy(c_str, str.c_str(), str.size() + 1);
+        return c_str;
+      }
+    }
+
+    unsigned long long hash_contents(const char* contents)
+    {
+      // 64-bit FNV-1a
+      unsigned long long h = 14695981039346656037ULL;
+      for (const unsigned char* p = (const unsigned char*) contents; *p; ++p) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+      }
+      return h;
+    }
+
+    char* convert_indented(const char* contents, unsigned long long key)
+    {
+      {
+        Cache_Guard guard;
+        map<unsigned long long, Converted_Source>::iterator hit = converted_sources.find(key);
+        if (hit != converted_sources.end() && hit->second.source == contents) {
+          return copy_to_c_str(hit->second.converted);
+        }
+      }
+      // convert without holding the lock; another thread converting the
+      // same source at the same time merely stores the same result
+      char* converted = sass2scss(contents, SASS2SCSS_PRETTIFY_1);
+      Converted_Source entry;
+      entry.source = contents;
+      entry.converted = converted;
+      size_t size = entry.source.size() + entry.converted.size();
+      if (size <= converted_sources_limit) {
+        Cache_Guard guard;
+        map<unsigned long long, Converted_Source>::iterator old = converted_sources.find(key);
+        if (old != converted_sources.end()) {
+          converted_sources_size -= old->second.source.size() + old->second.converted.size();
+          converted_sources.erase(old);
+        }
+        if (converted_sources_size + size > converted_sources_limit) {
+          converted_sources.clear();
+          converted_sources_size = 0;
+        }
+        converted_sources[key] = entry;
+        converted_sources_size += size;
+      }
+      return converted;
+    }
+
+    // the hash, if it's asked for, is of the file as it is on the disk,
+    // before an indented-syntax file is converted
+    char* read_file(string path, unsigned long long* hash, Source_Cache* cache)
     {
       struct stat st;
       if (stat(path.c_str(), &st) == -1 || S_ISDIR(st.st_mode)) return 0;
+      if (cache) {
+        char* cached = cache->find(path, st.st_mtime, st.st_size, hash);
+        if (cached) return cached;
+      }
       ifstream file(path.c_str(), ios::in | ios::binary | ios::ate);
       string extension;
       if (path.length() > 5) {
@@ -182,15 +307,18 @@ namespace Sass {
         contents[size] = '\0';
         file.close();
       }
+      if (contents == 0) return 0;
       for(size_t i=0; i<extension.size();++i)
         extension[i] = tolower(extension[i]);
-      if (extension == ".sass" && contents != 0) {
-        char * converted = sass2scss(contents, SASS2SCSS_PRETTIFY_1);
+      unsigned long long contents_hash = hash_contents(contents);
+      if (hash) *hash = contents_hash;
+      if (extension == ".sass") {
+        char* converted = convert_indented(contents, contents_hash);
         delete[] contents; // free the indented contents
-        return converted; // should be freed by caller
-      } else {
-        return contents;
+        contents = converted; // should be freed by caller
       }
+      if (cache) cache->store(path, contents, contents_hash, st.st_mtime, st.st_size);
+      return contents;
     }
 
   }
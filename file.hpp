@@ -1,8 +1,36 @@
+#define SASS_FILE
+
 #include <string>
+#include <map>
 
 namespace Sass {
   using namespace std;
   struct Context;
+
+  // The files loaded by the compiles it's given to, as they were loaded
+  // (indented syntax already converted) together with the hashes of them
+  // as they are on the disk.  A long-lived compiler such as sassc --watch
+  // keeps one across its compiles, so that only the files which have
+  // changed since are read and converted again.  An entry is reused while
+  // the modification time and the size of the file stay the same; a file
+  // known to have changed otherwise (e.g. by inotify) should be forgotten.
+  class Source_Cache {
+    struct Source {
+      string             contents;
+      unsigned long long hash;
+      long long          mtime;
+      long long          size;
+    };
+    map<string, Source> sources;
+
+  public:
+    // a copy of the contents of the file, or 0 if it isn't cached or
+    // has been modified since
+    char* find(const string& path, long long mtime, long long size, unsigned long long* hash) const;
+    void store(const string& path, const char* contents, unsigned long long hash, long long mtime, long long size);
+    void forget(const string& path);
+  };
+
   namespace File {
     string base_name(string);
     string dir_name(string);
@@ -10,7 +38,9 @@ namespace Sass {
     bool is_absolute_path(const string& path);
     string make_absolute_path(const string& path, const string& cwd);
     string resolve_relative_path(const string& uri, const string& base, const string& cwd);
-    char* resolve_and_load(string path, string& real_path);
-    char* read_file(string path);
+    char* resolve_and_load(string path, string& real_path, unsigned long long* hash = 0, Source_Cache* cache = 0);
+    char* read_file(string path, unsigned long long* hash = 0, Source_Cache* cache = 0);
+    unsigned long long hash_contents(const char* contents);
+    char* convert_indented(const char* contents, unsigned long long hash);
   }
 }
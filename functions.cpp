@@ -706,7 +706,7 @@ namespace Sass {
 
       size_t len = UTF_8::code_point_count(str, i, length_of_s);
 
-      return new (ctx.mem) Number(path, position, len);
+      return ctx.unitless_number(path, position, len);
     }
 
     Signature str_insert_sig = "str-insert($string, $insert, $index)";
@@ -764,11 +764,11 @@ namespace Sass {
 
       size_t c_index = str.find(substr);
       if(c_index == string::npos) {
-        return new (ctx.mem) Null(path, position);
+        return ctx.null_value;
       }
       size_t index = UTF_8::code_point_count(str, 0, c_index + 1);
 
-      return new (ctx.mem) Number(path, position, index);
+      return ctx.unitless_number(path, position, index);
     }
 
     Signature str_slice_sig = "str-slice($string, $start-at, $end-at:-1)";
@@ -918,9 +918,7 @@ namespace Sass {
     BUILT_IN(length)
     {
       List* list = dynamic_cast<List*>(env["$list"]);
-      return new (ctx.mem) Number(path,
-                                  position,
-                                  list ? list->length() : 1);
+      return ctx.unitless_number(path, position, list ? list->length() : 1);
     }
 
     Signature nth_sig = "nth($list, $n)";
@@ -950,9 +948,9 @@ namespace Sass {
         *l << ARG("$list", Expression);
       }
       for (size_t i = 0, L = l->length(); i < L; ++i) {
-        if (eq(l->value_at_index(i), v, ctx)) return new (ctx.mem) Number(path, position, i+1);
+        if (eq(l->value_at_index(i), v, ctx)) return ctx.unitless_number(path, position, i+1);
       }
-      return new (ctx.mem) Boolean(path, position, false);
+      return ctx.false_value;
     }
 
     Signature join_sig = "join($list1, $list2, $separator: auto)";
@@ -971,12 +969,11 @@ namespace Sass {
         l2 = new (ctx.mem) List(path, position, 1);
         *l2 << ARG("$list2", Expression);
       }
-      size_t len = l1->length() + l2->length();
       string sep_str = unquote(sep->value());
       if (sep_str == "space") sep_val = List::SPACE;
       else if (sep_str == "comma") sep_val = List::COMMA;
       else if (sep_str != "auto") error("argument `$separator` of `" + string(sig) + "` must be `space`, `comma`, or `auto`", path, position);
-      List* result = new (ctx.mem) List(path, position, len, sep_val);
+      List* result = new (ctx.mem) List(path, position, 0, sep_val);
       *result += l1;
       *result += l2;
       return result;
@@ -992,7 +989,7 @@ namespace Sass {
         l = new (ctx.mem) List(path, position, 1);
         *l << ARG("$list", Expression);
       }
-      List* result = new (ctx.mem) List(path, position, l->length() + 1, l->separator());
+      List* result = new (ctx.mem) List(path, position, 0, l->separator());
       string sep_str(unquote(sep->value()));
       if (sep_str == "space") result->separator(List::SPACE);
       else if (sep_str == "comma") result->separator(List::COMMA);
@@ -1005,27 +1002,24 @@ namespace Sass {
     Signature zip_sig = "zip($lists...)";
     BUILT_IN(zip)
     {
-      List* arglist = new (ctx.mem) List(*ARG("$lists", List));
+      List* arglist = ARG("$lists", List);
+      vector<List*> lists;
       size_t shortest = 0;
       for (size_t i = 0, L = arglist->length(); i < L; ++i) {
         List* ith = dynamic_cast<List*>(arglist->value_at_index(i));
         if (!ith) {
           ith = new (ctx.mem) List(path, position, 1);
           *ith << arglist->value_at_index(i);
-          if (arglist->is_arglist()) {
-            ((Argument*)(*arglist)[i])->value(ith);
-          } else {
-            (*arglist)[i] = ith;
-          }
         }
+        lists.push_back(ith);
         shortest = (i ? std::min(shortest, ith->length()) : ith->length());
       }
       List* zippers = new (ctx.mem) List(path, position, shortest, List::COMMA);
-      size_t L = arglist->length();
+      size_t L = lists.size();
       for (size_t i = 0; i < shortest; ++i) {
         List* zipper = new (ctx.mem) List(path, position, L);
         for (size_t j = 0; j < L; ++j) {
-          *zipper << (*static_cast<List*>(arglist->value_at_index(j)))[i];
+          *zipper << (*lists[j])[i];
         }
         *zippers << zipper;
       }
@@ -1080,7 +1074,7 @@ namespace Sass {
 
     Signature unitless_sig = "unitless($number)";
     BUILT_IN(unitless)
-    { return new (ctx.mem) Boolean(path, position, ARG("$number", Number)->is_unitless()); }
+    { return ARG("$number", Number)->is_unitless() ? ctx.true_value : ctx.false_value; }
 
     Signature comparable_sig = "comparable($number-1, $number-2)";
     BUILT_IN(comparable)
@@ -1088,11 +1082,11 @@ namespace Sass {
       Number* n1 = ARG("$number-1", Number);
       Number* n2 = ARG("$number-2", Number);
       if (n1->is_unitless() || n2->is_unitless()) {
-        return new (ctx.mem) Boolean(path, position, true);
+        return ctx.true_value;
       }
       Number tmp_n2(*n2);
       tmp_n2.normalize(n1->find_convertible_unit());
-      return new (ctx.mem) Boolean(path, position, n1->unit() == tmp_n2.unit());
+      return n1->unit() == tmp_n2.unit() ? ctx.true_value : ctx.false_value;
     }
 
     ////////////////////
@@ -1101,7 +1095,7 @@ namespace Sass {
 
     Signature not_sig = "not($value)";
     BUILT_IN(sass_not)
-    { return new (ctx.mem) Boolean(path, position, ARG("$value", Expression)->is_false()); }
+    { return ARG("$value", Expression)->is_false() ? ctx.true_value : ctx.false_value; }
 
     Signature if_sig = "if($condition, $if-true, $if-false)";
     BUILT_IN(sass_if)
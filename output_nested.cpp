@@ -71,7 +71,7 @@ namespace Sass {
       indent();
       if (source_comments) {
         stringstream ss;
-        ss << "/* line " << r->position().line << ", " << r->path() << " */" << endl;
+        ss << "/* line " << r->position().line() << ", " << r->path() << " */" << endl;
         append_to_buffer(ss.str());
         indent();
       }
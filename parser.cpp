@@ -31,72 +31,86 @@ namespace Sass {
     p.source   = t.begin;
     p.position = p.source;
     p.end      = t.end;
+    Line_Index* lines = source_position.line_index();
+    if (lines && lines->contains(t.begin)) p.line_index = lines;
     return p;
   }
 
+  void Parser::index_lines()
+  {
+    line_index = new Line_Index(source, end);
+    ctx.line_indices.push_back(line_index);
+    start_position = Position(start_position.file, line_index, 0, 0);
+  }
+
   Block* Parser::parse()
   {
-    Block* root = new (ctx.mem) Block(path, source_position);
+    Block* root = new (ctx.mem) Block(path, source_position());
     root->is_root(true);
     read_bom();
     lex< optional_spaces >();
     Selector_Lookahead lookahead_result;
     while (position < end) {
+      // dispatch on the first significant character, and on the keyword
+      // of directives, instead of trying each kind of statement in turn
+      const char* start = skip_spaces_and_comments(position);
+      Directive directive = lookup_directive(start);
       if (lex< block_comment >()) {
         String*  contents = parse_interpolated_chunk(lexed);
-        Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+        Comment* comment  = new (ctx.mem) Comment(path, source_position(), contents);
         (*root) << comment;
       }
-      else if (peek< import >()) {
+      else if (directive == at_import) {
         Import* imp = parse_import();
         if (!imp->urls().empty()) (*root) << imp;
         if (!imp->files().empty()) {
           for (size_t i = 0, S = imp->files().size(); i < S; ++i) {
-            (*root) << new (ctx.mem) Import_Stub(path, source_position, imp->files()[i]);
+            (*root) << new (ctx.mem) Import_Stub(path, source_position(), imp->files()[i]);
           }
         }
         if (!lex< exactly<';'> >()) error("top-level @import directive must be terminated by ';'");
       }
-      else if (peek< mixin >() || peek< function >()) {
+      else if (directive == at_mixin || directive == at_function) {
         (*root) << parse_definition();
       }
-      else if (peek< variable >()) {
+      else if (*start == '$' && peek< variable >()) {
         (*root) << parse_assignment();
         if (!lex< exactly<';'> >()) error("top-level variable binding must be terminated by ';'");
       }
-      else if (peek< sequence< optional< exactly<'*'> >, alternatives< identifier_schema, identifier >, optional_spaces, exactly<':'>, optional_spaces, exactly<'{'> > >(position)) {
+      else if (!directive && *start != '$' && peek< sequence< optional< exactly<'*'> >, alternatives< identifier_schema, identifier >, optional_spaces, exactly<':'>, optional_spaces, exactly<'{'> > >(position)) {
         (*root) << parse_propset();
       }
-      else if (peek< include >() /* || peek< exactly<'+'> >() */) {
+      else if (directive == at_include /* || peek< exactly<'+'> >() */) {
         Mixin_Call* mixin_call = parse_mixin_call();
         (*root) << mixin_call;
         if (!mixin_call->block() && !lex< exactly<';'> >()) error("top-level @include directive must be terminated by ';'");
       }
-      else if (peek< if_directive >()) {
+      else if (directive == at_if) {
         (*root) << parse_if_directive();
       }
-      else if (peek< for_directive >()) {
+      else if (directive == at_for) {
         (*root) << parse_for_directive();
       }
-      else if (peek< each_directive >()) {
+      else if (directive == at_each) {
         (*root) << parse_each_directive();
       }
-      else if (peek< while_directive >()) {
+      else if (directive == at_while) {
         (*root) << parse_while_directive();
       }
-      else if (peek< media >()) {
+      else if (directive == at_media) {
         (*root) << parse_media_block();
       }
-      else if (peek< warn >()) {
+      else if (directive == at_warn) {
         (*root) << parse_warning();
         if (!lex< exactly<';'> >()) error("top-level @warn directive must be terminated by ';'");
       }
       // ignore the @charset directive for now
-      else if (lex< exactly< charset_kwd > >()) {
+      else if (directive == at_charset) {
+        lex< exactly< charset_kwd > >();
         lex< string_constant >();
         lex< exactly<';'> >();
       }
-      else if (peek< at_keyword >()) {
+      else if (directive && peek< at_keyword >()) {
         At_Rule* at_rule = parse_at_rule();
         (*root) << at_rule;
         if (!at_rule->block() && !lex< exactly<';'> >()) error("top-level directive must be terminated by ';'");
@@ -114,10 +128,43 @@ namespace Sass {
     return root;
   }
 
+  // The keywords of the statement directives, indexed by Directive.
+  static const char* directive_keywords[] = {
+    0,
+    import_kwd, mixin_kwd, function_kwd, return_kwd, include_kwd,
+    content_kwd, extend_kwd, if_kwd, for_kwd, each_kwd, while_kwd,
+    warn_kwd, media_kwd, charset_kwd,
+    0
+  };
+
+  // Tells which directive starts at start by a trie walk over the first
+  // letters of the keywords, checking the rest of only the one it finds.
+  // No keyword is a prefix of another, so this agrees with trying their
+  // matchers in turn.
+  Parser::Directive Parser::lookup_directive(const char* start)
+  {
+    if (*start != '@') return no_directive;
+    Directive directive;
+    switch (start[1]) {
+      case 'c': directive = start[2] == 'h' ? at_charset : at_content; break;
+      case 'e': directive = start[2] == 'a' ? at_each : at_extend; break;
+      case 'f': directive = start[2] == 'o' ? at_for : at_function; break;
+      case 'i': directive = start[2] == 'f' ? at_if :
+                            start[2] == 'm' ? at_import : at_include; break;
+      case 'm': directive = start[2] == 'e' ? at_media : at_mixin; break;
+      case 'r': directive = at_return; break;
+      case 'w': directive = start[2] == 'a' ? at_warn : at_while; break;
+      default:  return at_other;
+    }
+    const char* kwd = directive_keywords[directive];
+    while (*kwd && *start == *kwd) ++start, ++kwd;
+    return *kwd ? at_other : directive;
+  }
+
   Import* Parser::parse_import()
   {
     lex< import >();
-    Import* imp = new (ctx.mem) Import(path, source_position);
+    Import* imp = new (ctx.mem) Import(path, source_position());
     bool first = true;
     do {
       if (lex< string_constant >()) {
@@ -128,17 +175,18 @@ namespace Sass {
           extension = import_path.substr(import_path.length() - 5, 4);
         }
         if (extension == ".css") {
-          String_Constant* loc = new (ctx.mem) String_Constant(path, source_position, import_path, true);
-          Argument* loc_arg = new (ctx.mem) Argument(path, source_position, loc);
-          Arguments* loc_args = new (ctx.mem) Arguments(path, source_position);
+          String_Constant* loc = new (ctx.mem) String_Constant(path, source_position(), import_path, true);
+          Argument* loc_arg = new (ctx.mem) Argument(path, source_position(), loc);
+          Arguments* loc_args = new (ctx.mem) Arguments(path, source_position());
           (*loc_args) << loc_arg;
-          Function_Call* new_url = new (ctx.mem) Function_Call(path, source_position, "url", loc_args);
+          Function_Call* new_url = new (ctx.mem) Function_Call(path, source_position(), "url", loc_args);
           imp->urls().push_back(new_url);
         }
         else {
           string current_dir = File::dir_name(path);
           string resolved(ctx.add_file(current_dir, unquote(import_path)));
           if (resolved.empty()) error("file to import not found or unreadable: " + import_path);
+          ctx.add_import(path, resolved);
           imp->files().push_back(resolved);
         }
       }
@@ -162,7 +210,7 @@ namespace Sass {
     string which_str(lexed);
     if (!lex< identifier >()) error("invalid name in " + which_str + " definition");
     string name(lexed);
-    Position source_position_of_def = source_position;
+    Position source_position_of_def = source_position();
     Parameters* params = parse_parameters();
     if (!peek< exactly<'{'> >()) error("body for " + which_str + " " + name + " must begin with a '{'");
     if (which_type == Definition::MIXIN) stack.push_back(mixin_def);
@@ -176,7 +224,7 @@ namespace Sass {
   Parameters* Parser::parse_parameters()
   {
     string name(lexed); // for the error message
-    Parameters* params = new (ctx.mem) Parameters(path, source_position);
+    Parameters* params = new (ctx.mem) Parameters(path, source_position());
     if (lex< exactly<'('> >()) {
       // if there's anything there at all
       if (!peek< exactly<')'> >()) {
@@ -192,7 +240,7 @@ namespace Sass {
   {
     lex< variable >();
     string name(lexed);
-    Position pos = source_position;
+    Position pos = source_position();
     Expression* val = 0;
     bool is_rest = false;
     if (lex< exactly<':'> >()) { // there's a default value
@@ -210,7 +258,7 @@ namespace Sass {
   {
     lex< include >() /* || lex< exactly<'+'> >() */;
     if (!lex< identifier >()) error("invalid name in @include directive");
-    Position source_position_of_call = source_position;
+    Position source_position_of_call = source_position();
     string name(lexed);
     Arguments* args = parse_arguments();
     Block* content = 0;
@@ -224,7 +272,7 @@ namespace Sass {
   Arguments* Parser::parse_arguments()
   {
     string name(lexed);
-    Arguments* args = new (ctx.mem) Arguments(path, source_position);
+    Arguments* args = new (ctx.mem) Arguments(path, source_position());
 
     if (lex< exactly<'('> >()) {
       // if there's anything there at all
@@ -244,7 +292,7 @@ namespace Sass {
     if (peek< sequence < variable, spaces_and_comments, exactly<':'> > >()) {
       lex< variable >();
       string name(lexed);
-      Position p = source_position;
+      Position p = source_position();
       lex< exactly<':'> >();
       Expression* val = parse_space_list();
       val->is_delayed(false);
@@ -257,7 +305,7 @@ namespace Sass {
       if (lex< exactly< ellipsis > >()) {
         is_arglist = true;
       }
-      arg = new (ctx.mem) Argument(path, source_position, val, "", is_arglist);
+      arg = new (ctx.mem) Argument(path, source_position(), val, "", is_arglist);
     }
     return arg;
   }
@@ -266,7 +314,7 @@ namespace Sass {
   {
     lex< variable >();
     string name(lexed);
-    Position var_source_position = source_position;
+    Position var_source_position = source_position();
     if (!lex< exactly<':'> >()) error("expected ':' after " + name + " in assignment statement");
     Expression* val = parse_list();
     val->is_delayed(false);
@@ -283,9 +331,9 @@ namespace Sass {
     }
     else {
       lex< sequence< optional< exactly<'*'> >, identifier > >();
-      property_segment = new (ctx.mem) String_Constant(path, source_position, lexed);
+      property_segment = new (ctx.mem) String_Constant(path, source_position(), lexed);
     }
-    Propset* propset = new (ctx.mem) Propset(path, source_position, property_segment);
+    Propset* propset = new (ctx.mem) Propset(path, source_position(), property_segment);
     lex< exactly<':'> >();
 
     if (!peek< exactly<'{'> >()) error("expected a '{' after namespaced property");
@@ -301,10 +349,13 @@ namespace Sass {
     if (lookahead.has_interpolants) {
       sel = parse_selector_schema(lookahead.found);
     }
+    else if (lookahead.is_plain) {
+      sel = parse_plain_selector_group();
+    }
     else {
       sel = parse_selector_group();
     }
-    Position r_source_position = source_position;
+    Position r_source_position = source_position();
     if (!peek< exactly<'{'> >()) error("expected a '{' after the selector");
     Block* block = parse_block();
     Ruleset* ruleset = new (ctx.mem) Ruleset(path, r_source_position, sel, block);
@@ -316,63 +367,68 @@ namespace Sass {
     lex< optional_spaces >();
     const char* i = position;
     const char* p;
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position());
 
     while (i < end_of_selector) {
       p = find_first_in_interval< exactly<hash_lbrace> >(i, end_of_selector);
       if (p) {
         // accumulate the preceding segment if there is one
-        if (i < p) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p));
+        if (i < p) (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, p));
         // find the end of the interpolant and parse it
         const char* j = find_first_in_interval< exactly<rbrace> >(p, end_of_selector);
-        Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+        Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position()).parse_list();
         interp_node->is_interpolant(true);
         (*schema) << interp_node;
         i = j + 1;
       }
       else { // no interpolants left; add the last segment if there is one
-        if (i < end_of_selector) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, end_of_selector));
+        if (i < end_of_selector) (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, end_of_selector));
         break;
       }
     }
     position = end_of_selector;
-    return new (ctx.mem) Selector_Schema(path, source_position, schema);
+    return new (ctx.mem) Selector_Schema(path, source_position(), schema);
   }
 
   Selector_List* Parser::parse_selector_group()
   {
     To_String to_string;
-    Selector_List* group = new (ctx.mem) Selector_List(path, source_position);
+    Selector_List* group = new (ctx.mem) Selector_List(path, source_position());
     do {
       if (peek< exactly<'{'> >() ||
           peek< exactly<'}'> >() ||
           peek< exactly<')'> >() ||
           peek< exactly<';'> >())
         break; // in case there are superfluous commas at the end
-      Complex_Selector* comb = parse_selector_combination();
-      if (!comb->has_reference()) {
-        Position sel_source_position = source_position;
-        Selector_Reference* ref = new (ctx.mem) Selector_Reference(path, sel_source_position);
-        Compound_Selector* ref_wrap = new (ctx.mem) Compound_Selector(path, sel_source_position);
-        (*ref_wrap) << ref;
-        if (!comb->head()) {
-          comb->head(ref_wrap);
-          comb->has_reference(true);
-        }
-        else {
-          comb = new (ctx.mem) Complex_Selector(path, sel_source_position, Complex_Selector::ANCESTOR_OF, ref_wrap, comb);
-          comb->has_reference(true);
-        }
-      }
-      (*group) << comb;
+      (*group) << add_parent_reference(parse_selector_combination());
     }
     while (lex< one_plus< sequence< spaces_and_comments, exactly<','> > > >());
     return group;
   }
 
+  Complex_Selector* Parser::add_parent_reference(Complex_Selector* comb)
+  {
+    if (!comb->has_reference()) {
+      Position sel_source_position = source_position();
+      Selector_Reference* ref = new (ctx.mem) Selector_Reference(path, sel_source_position);
+      Compound_Selector* ref_wrap = new (ctx.mem) Compound_Selector(path, sel_source_position);
+      (*ref_wrap) << ref;
+      if (!comb->head()) {
+        comb->head(ref_wrap);
+        comb->has_reference(true);
+      }
+      else {
+        comb = new (ctx.mem) Complex_Selector(path, sel_source_position, Complex_Selector::ANCESTOR_OF, ref_wrap, comb);
+        comb->has_reference(true);
+      }
+    }
+    return comb;
+  }
+
   Complex_Selector* Parser::parse_selector_combination()
   {
-    Position sel_source_position = Position();
+    Position sel_source_position;
+    bool has_source_position = false;
     Compound_Selector* lhs;
     if (peek< exactly<'+'> >() ||
         peek< exactly<'~'> >() ||
@@ -382,7 +438,8 @@ namespace Sass {
     }
     else {
       lhs = parse_simple_selector_sequence();
-      sel_source_position = source_position;
+      sel_source_position = source_position();
+      has_source_position = true;
     }
 
     Complex_Selector::Combinator cmb;
@@ -402,19 +459,20 @@ namespace Sass {
     }
     else {
       rhs = parse_selector_combination();
-      sel_source_position = source_position;
+      sel_source_position = source_position();
+      has_source_position = true;
     }
-    if (!sel_source_position.line) sel_source_position = source_position;
+    if (!has_source_position) sel_source_position = source_position();
     return new (ctx.mem) Complex_Selector(path, sel_source_position, cmb, lhs, rhs);
   }
 
   Compound_Selector* Parser::parse_simple_selector_sequence()
   {
-    Compound_Selector* seq = new (ctx.mem) Compound_Selector(path, source_position);
+    Compound_Selector* seq = new (ctx.mem) Compound_Selector(path, source_position());
     bool sawsomething = false;
     if (lex< exactly<'&'> >()) {
       // if you see a &
-      (*seq) << new (ctx.mem) Selector_Reference(path, source_position);
+      (*seq) << new (ctx.mem) Selector_Reference(path, source_position());
       sawsomething = true;
       // if you see a space after a &, then you're done
       if(lex< spaces >()) {
@@ -423,10 +481,10 @@ namespace Sass {
     }
     if (sawsomething && lex< sequence< negate< functional >, alternatives< hyphens_and_identifier, universal, string_constant, dimension, percentage, number > > >()) {
       // saw an ampersand, then allow type selectors with arbitrary number of hyphens at the beginning
-      (*seq) << new (ctx.mem) Type_Selector(path, source_position, lexed);
+      (*seq) << new (ctx.mem) Type_Selector(path, source_position(), lexed);
     } else if (lex< sequence< negate< functional >, alternatives< type_selector, universal, string_constant, dimension, percentage, number > > >()) {
       // if you see a type selector
-      (*seq) << new (ctx.mem) Type_Selector(path, source_position, lexed);
+      (*seq) << new (ctx.mem) Type_Selector(path, source_position(), lexed);
       sawsomething = true;
     }
     if (!sawsomething) {
@@ -448,13 +506,98 @@ namespace Sass {
     return seq;
   }
 
+  // The plain selector parsers build the same selectors, at the same source
+  // positions, as the ones above would out of the selector_tokens, which
+  // are known to be well-formed already.
+  Selector_List* Parser::parse_plain_selector_group()
+  {
+    const Selector_Token* token = &selector_tokens[0];
+    const Selector_Token* last = token + selector_tokens.size();
+    Selector_List* group = new (ctx.mem) Selector_List(path, source_position());
+    while (true) {
+      if (token == last) break; // in case there are superfluous commas at the end
+      (*group) << add_parent_reference(parse_plain_selector_combination(token, last));
+      if (token == last || token->kind != Selector_Token::COMMA) break;
+      const char* commas = token->begin;
+      while (token != last && token->kind == Selector_Token::COMMA) lex_selector_token(token);
+      lexed.begin = commas;
+    }
+    return group;
+  }
+
+  Complex_Selector* Parser::parse_plain_selector_combination(const Selector_Token*& token, const Selector_Token* last)
+  {
+    Position sel_source_position;
+    bool has_source_position = false;
+    Compound_Selector* lhs;
+    if (token != last && token->kind == Selector_Token::COMBINATOR) {
+      // no selector before the combinator
+      lhs = 0;
+    }
+    else {
+      lhs = parse_plain_selector_sequence(token, last);
+      sel_source_position = source_position();
+      has_source_position = true;
+    }
+
+    Complex_Selector::Combinator cmb = Complex_Selector::ANCESTOR_OF;
+    if (token != last && token->kind == Selector_Token::COMBINATOR) {
+      switch (*token->begin) {
+        case '+': cmb = Complex_Selector::ADJACENT_TO; break;
+        case '~': cmb = Complex_Selector::PRECEDES;    break;
+        default:  cmb = Complex_Selector::PARENT_OF;   break;
+      }
+      lex_selector_token(token);
+    }
+
+    Complex_Selector* rhs;
+    if (token == last || token->kind == Selector_Token::COMMA) {
+      // no selector after the combinator
+      rhs = 0;
+    }
+    else {
+      rhs = parse_plain_selector_combination(token, last);
+      sel_source_position = source_position();
+      has_source_position = true;
+    }
+    if (!has_source_position) sel_source_position = source_position();
+    return new (ctx.mem) Complex_Selector(path, sel_source_position, cmb, lhs, rhs);
+  }
+
+  Compound_Selector* Parser::parse_plain_selector_sequence(const Selector_Token*& token, const Selector_Token* last)
+  {
+    Compound_Selector* seq = new (ctx.mem) Compound_Selector(path, source_position());
+    if (token->kind == Selector_Token::TYPE_NAME) {
+      lex_selector_token(token);
+      (*seq) << new (ctx.mem) Type_Selector(path, source_position(), lexed);
+    }
+    else {
+      lex_selector_token(token);
+      (*seq) << new (ctx.mem) Selector_Qualifier(path, source_position(), lexed);
+    }
+    // the names that follow without spaces in between
+    while (token != last && token->begin == position &&
+           (token->kind == Selector_Token::CLASS_NAME || token->kind == Selector_Token::ID_NAME)) {
+      lex_selector_token(token);
+      (*seq) << new (ctx.mem) Selector_Qualifier(path, source_position(), lexed);
+    }
+    return seq;
+  }
+
+  void Parser::lex_selector_token(const Selector_Token*& token)
+  {
+    lexed = Token(token->begin, token->end);
+    position = token->end;
+    ++token;
+  }
+
   Simple_Selector* Parser::parse_simple_selector()
   {
     if (lex< id_name >() || lex< class_name >()) {
-      return new (ctx.mem) Selector_Qualifier(path, source_position, lexed);
+      return new (ctx.mem) Selector_Qualifier(path, source_position(), lexed);
     }
     else if (lex< string_constant >() || lex< number >()) {
-      return new (ctx.mem) Type_Selector(path, source_position, lexed);
+      return new (ctx.mem) Type_Selector(path, source_position(), lexed);
     }
     else if (peek< pseudo_not >()) {
       return parse_negated_selector();
@@ -466,7 +609,7 @@ namespace Sass {
       return parse_attribute_selector();
     }
     else if (lex< placeholder >()) {
-      return new (ctx.mem) Selector_Placeholder(path, source_position, lexed);
+      return new (ctx.mem) Selector_Placeholder(path, source_position(), lexed);
     }
     else {
       error("invalid selector after " + lexed.to_string());
@@ -478,7 +621,7 @@ namespace Sass {
   Negated_Selector* Parser::parse_negated_selector()
   {
     lex< pseudo_not >();
-    Position nsource_position = source_position;
+    Position nsource_position = source_position();
     Selector* negated = parse_selector_group();
     if (!lex< exactly<')'> >()) {
       error("negated selector is missing ')'");
@@ -490,7 +633,7 @@ namespace Sass {
     if (lex< sequence< pseudo_prefix, functional > >() || lex< functional >()) {
       string name(lexed);
       String* expr = 0;
-      Position p = source_position;
+      Position p = source_position();
       if (lex< alternatives< even, odd > >()) {
         expr = new (ctx.mem) String_Constant(path, p, lexed);
       }
@@ -536,7 +679,7 @@ namespace Sass {
       return new (ctx.mem) Pseudo_Selector(path, p, name, expr);
     }
     else if (lex < sequence< pseudo_prefix, identifier > >()) {
-      return new (ctx.mem) Pseudo_Selector(path, source_position, lexed);
+      return new (ctx.mem) Pseudo_Selector(path, source_position(), lexed);
     }
     else {
       error("unrecognized pseudo-class or pseudo-element");
@@ -548,7 +691,7 @@ namespace Sass {
   Attribute_Selector* Parser::parse_attribute_selector()
   {
     lex< exactly<'['> >();
-    Position p = source_position;
+    Position p = source_position();
     if (!lex< attribute_name >()) error("invalid attribute name in attribute selector");
     string name(lexed);
     if (lex< exactly<']'> >()) return new (ctx.mem) Attribute_Selector(path, p, name, "", 0);
@@ -578,7 +721,7 @@ namespace Sass {
     lex< exactly<'{'> >();
     bool semicolon = false;
     Selector_Lookahead lookahead_result;
-    Block* block = new (ctx.mem) Block(path, source_position);
+    Block* block = new (ctx.mem) Block(path, source_position());
     while (!lex< exactly<'}'> >()) {
       if (semicolon) {
         if (!lex< exactly<';'> >()) {
@@ -587,17 +730,19 @@ namespace Sass {
         semicolon = false;
         while (lex< block_comment >()) {
           String*  contents = parse_interpolated_chunk(lexed);
-          Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+          Comment* comment  = new (ctx.mem) Comment(path, source_position(), contents);
           (*block) << comment;
         }
         if (lex< exactly<'}'> >()) break;
       }
+      const char* start = skip_spaces_and_comments(position);
+      Directive directive = lookup_directive(start);
       if (lex< block_comment >()) {
         String*  contents = parse_interpolated_chunk(lexed);
-        Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+        Comment* comment  = new (ctx.mem) Comment(path, source_position(), contents);
         (*block) << comment;
       }
-      else if (peek< import >(position)) {
+      else if (directive == at_import) {
         if (stack.back() == mixin_def || stack.back() == function_def) {
           lex< import >(); // to adjust the source_position number
           error("@import directives are not allowed inside mixins and functions");
@@ -606,52 +751,54 @@ namespace Sass {
         if (!imp->urls().empty()) (*block) << imp;
         if (!imp->files().empty()) {
           for (size_t i = 0, S = imp->files().size(); i < S; ++i) {
-            (*block) << new (ctx.mem) Import_Stub(path, source_position, imp->files()[i]);
+            (*block) << new (ctx.mem) Import_Stub(path, source_position(), imp->files()[i]);
           }
         }
         semicolon = true;
       }
-      else if (lex< variable >()) {
+      else if (*start == '$' && lex< variable >()) {
         (*block) << parse_assignment();
         semicolon = true;
       }
-      else if (peek< if_directive >()) {
+      else if (directive == at_if) {
         (*block) << parse_if_directive();
       }
-      else if (peek< for_directive >()) {
+      else if (directive == at_for) {
         (*block) << parse_for_directive();
       }
-      else if (peek< each_directive >()) {
+      else if (directive == at_each) {
         (*block) << parse_each_directive();
       }
-      else if (peek < while_directive >()) {
+      else if (directive == at_while) {
         (*block) << parse_while_directive();
       }
-      else if (lex < return_directive >()) {
-        (*block) << new (ctx.mem) Return(path, source_position, parse_list());
+      else if (directive == at_return) {
+        lex< return_directive >();
+        (*block) << new (ctx.mem) Return(path, source_position(), parse_list());
         semicolon = true;
       }
-      else if (peek< warn >()) {
+      else if (directive == at_warn) {
         (*block) << parse_warning();
         semicolon = true;
       }
       else if (stack.back() == function_def) {
         error("only variable declarations and control directives are allowed inside functions");
       }
-      else if (peek< mixin >() || peek< function >()) {
+      else if (directive == at_mixin || directive == at_function) {
         (*block) << parse_definition();
       }
-      else if (peek< include >(position)) {
+      else if (directive == at_include) {
         Mixin_Call* the_call = parse_mixin_call();
         (*block) << the_call;
         // don't need a semicolon after a content block
         semicolon = (the_call->block()) ? false : true;
       }
-      else if (lex< content >()) {
+      else if (directive == at_content) {
+        lex< content >();
         if (stack.back() != mixin_def) {
           error("@content may only be used within a mixin");
         }
-        (*block) << new (ctx.mem) Content(path, source_position);
+        (*block) << new (ctx.mem) Content(path, source_position());
         semicolon = true;
       }
       /*
@@ -660,24 +807,26 @@ namespace Sass {
         semicolon = true;
       }
       */
-      else if (lex< extend >()) {
+      else if (directive == at_extend) {
+        lex< extend >();
         Selector_Lookahead lookahead = lookahead_for_extension_target(position);
         if (!lookahead.found) error("invalid selector for @extend");
         Selector* target;
         if (lookahead.has_interpolants) target = parse_selector_schema(lookahead.found);
         else                            target = parse_selector_group();
-        (*block) << new (ctx.mem) Extension(path, source_position, target);
+        (*block) << new (ctx.mem) Extension(path, source_position(), target);
         semicolon = true;
       }
-      else if (peek< media >()) {
+      else if (directive == at_media) {
         (*block) << parse_media_block();
       }
       // ignore the @charset directive for now
-      else if (lex< exactly< charset_kwd > >()) {
+      else if (directive == at_charset) {
+        lex< exactly< charset_kwd > >();
         lex< string_constant >();
         lex< exactly<';'> >();
       }
-      else if (peek< at_keyword >()) {
+      else if (directive && peek< at_keyword >()) {
         At_Rule* at_rule = parse_at_rule();
         (*block) << at_rule;
         if (!at_rule->block()) semicolon = true;
@@ -685,10 +834,10 @@ namespace Sass {
       else if ((lookahead_result = lookahead_for_selector(position)).found) {
         (*block) << parse_ruleset(lookahead_result);
       }
-      else if (peek< sequence< optional< exactly<'*'> >, alternatives< identifier_schema, identifier >, optional_spaces, exactly<':'>, optional_spaces, exactly<'{'> > >(position)) {
+      else if (!directive && *start != '$' && peek< sequence< optional< exactly<'*'> >, alternatives< identifier_schema, identifier >, optional_spaces, exactly<':'>, optional_spaces, exactly<'{'> > >(position)) {
         (*block) << parse_propset();
       }
-      else if (!peek< exactly<';'> >()) {
+      else if (*start != ';') {
         if (peek< sequence< optional< exactly<'*'> >, identifier_schema, exactly<':'>, exactly<'{'> > >()) {
           (*block) << parse_propset();
         }
@@ -700,7 +849,7 @@ namespace Sass {
           (*block) << decl;
           if (peek< exactly<'{'> >()) {
             // parse a propset that rides on the declaration's property
-            Propset* ps = new (ctx.mem) Propset(path, source_position, decl->property(), parse_block());
+            Propset* ps = new (ctx.mem) Propset(path, source_position(), decl->property(), parse_block());
             (*block) << ps;
           }
           else {
@@ -712,7 +861,7 @@ namespace Sass {
       else lex< exactly<';'> >();
       while (lex< block_comment >()) {
         String*  contents = parse_interpolated_chunk(lexed);
-        Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+        Comment* comment  = new (ctx.mem) Comment(path, source_position(), contents);
         (*block) << comment;
       }
     }
@@ -725,7 +874,7 @@ namespace Sass {
       prop = parse_identifier_schema();
     }
     else if (lex< sequence< optional< exactly<'*'> >, identifier > >()) {
-      prop = new (ctx.mem) String_Constant(path, source_position, lexed);
+      prop = new (ctx.mem) String_Constant(path, source_position(), lexed);
     }
     else {
       error("invalid property name");
@@ -750,12 +899,12 @@ namespace Sass {
         peek< exactly<')'> >(position) ||
         //peek< exactly<':'> >(position) ||
         peek< exactly<ellipsis> >(position))
-    { return new (ctx.mem) List(path, source_position, 0); }
+    { return new (ctx.mem) List(path, source_position(), 0); }
     Expression* list1 = parse_space_list();
     // if it's a singleton, return it directly; don't wrap it
     if (!peek< exactly<','> >(position)) return list1;
 
-    List* comma_list = new (ctx.mem) List(path, source_position, 2, List::COMMA);
+    List* comma_list = new (ctx.mem) List(path, source_position(), 2, List::COMMA);
     (*comma_list) << list1;
 
     while (lex< exactly<','> >())
@@ -782,7 +931,7 @@ namespace Sass {
         peek< default_flag >(position))
     { return disj1; }
 
-    List* space_list = new (ctx.mem) List(path, source_position, 2, List::SPACE);
+    List* space_list = new (ctx.mem) List(path, source_position(), 2, List::SPACE);
     (*space_list) << disj1;
 
     while (!(//peek< exactly<'!'> >(position) ||
@@ -913,18 +1062,18 @@ namespace Sass {
       return parse_ie_stuff();
     }
     else if (peek< ie_keyword_arg >()) {
-      String_Schema* kwd_arg = new (ctx.mem) String_Schema(path, source_position, 3);
-      if (lex< variable >()) *kwd_arg << new (ctx.mem) Variable(path, source_position, lexed);
+      String_Schema* kwd_arg = new (ctx.mem) String_Schema(path, source_position(), 3);
+      if (lex< variable >()) *kwd_arg << new (ctx.mem) Variable(path, source_position(), lexed);
       else {
         lex< alternatives< identifier_schema, identifier > >();
-        *kwd_arg << new (ctx.mem) String_Constant(path, source_position, lexed);
+        *kwd_arg << new (ctx.mem) String_Constant(path, source_position(), lexed);
       }
       lex< exactly<'='> >();
-      *kwd_arg << new (ctx.mem) String_Constant(path, source_position, lexed);
-      if (lex< variable >()) *kwd_arg << new (ctx.mem) Variable(path, source_position, lexed);
+      *kwd_arg << new (ctx.mem) String_Constant(path, source_position(), lexed);
+      if (lex< variable >()) *kwd_arg << new (ctx.mem) Variable(path, source_position(), lexed);
       else {
         lex< alternatives< identifier_schema, identifier, number, hex > >();
-        *kwd_arg << new (ctx.mem) String_Constant(path, source_position, lexed);
+        *kwd_arg << new (ctx.mem) String_Constant(path, source_position(), lexed);
       }
       return kwd_arg;
     }
@@ -943,10 +1092,10 @@ namespace Sass {
       return parse_function_call();
     }
     else if (lex< sequence< exactly<'+'>, spaces_and_comments, negate< number > > >()) {
-      return new (ctx.mem) Unary_Expression(path, source_position, Unary_Expression::PLUS, parse_factor());
+      return new (ctx.mem) Unary_Expression(path, source_position(), Unary_Expression::PLUS, parse_factor());
     }
     else if (lex< sequence< exactly<'-'>, spaces_and_comments, negate< number> > >()) {
-      return new (ctx.mem) Unary_Expression(path, source_position, Unary_Expression::MINUS, parse_factor());
+      return new (ctx.mem) Unary_Expression(path, source_position(), Unary_Expression::MINUS, parse_factor());
     }
     else {
       return parse_value();
@@ -956,10 +1105,10 @@ namespace Sass {
   Expression* Parser::parse_value()
   {
     if (lex< uri_prefix >()) {
-      Arguments* args = new (ctx.mem) Arguments(path, source_position);
-      Function_Call* result = new (ctx.mem) Function_Call(path, source_position, "url", args);
+      Arguments* args = new (ctx.mem) Arguments(path, source_position());
+      Function_Call* result = new (ctx.mem) Function_Call(path, source_position(), "url", args);
       const char* here = position;
-      Position here_p = source_position;
+      Token here_lexed = lexed;
       // Try to parse a SassScript expression. If it succeeds and we can munch
       // a matching rparen, then that's our url. If we can't munch a matching
       // rparen, or if the attempt to parse an expression fails, then try to
@@ -977,7 +1126,7 @@ namespace Sass {
       catch (Error& err) {
         // back up so we can try again
         position = here;
-        source_position = here_p;
+        lexed = here_lexed;
       }
       lex< spaces >();
       if (lex< url >()) {
@@ -993,43 +1142,43 @@ namespace Sass {
     }
 
     if (lex< important >())
-    { return new (ctx.mem) String_Constant(path, source_position, "!important"); }
+    { return new (ctx.mem) String_Constant(path, source_position(), "!important"); }
 
     if (lex< value_schema >())
-    { return Parser::from_token(lexed, ctx, path, source_position).parse_value_schema(); }
+    { return Parser::from_token(lexed, ctx, path, source_position()).parse_value_schema(); }
 
     if (lex< sequence< true_val, negate< identifier > > >())
-    { return new (ctx.mem) Boolean(path, source_position, true); }
+    { return new (ctx.mem) Boolean(path, source_position(), true); }
 
     if (lex< sequence< false_val, negate< identifier > > >())
-    { return new (ctx.mem) Boolean(path, source_position, false); }
+    { return new (ctx.mem) Boolean(path, source_position(), false); }
 
     if (lex< sequence< null, negate< identifier > > >())
-    { return new (ctx.mem) Null(path, source_position); }
+    { return new (ctx.mem) Null(path, source_position()); }
 
     if (lex< identifier >()) {
-      String_Constant* str = new (ctx.mem) String_Constant(path, source_position, lexed);
+      String_Constant* str = new (ctx.mem) String_Constant(path, source_position(), lexed);
       str->is_delayed(true);
       return str;
     }
 
     if (lex< percentage >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::PERCENTAGE, lexed); }
+    { return lexed_textual(Textual::PERCENTAGE); }
 
     if (lex< dimension >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::DIMENSION, lexed); }
+    { return lexed_textual(Textual::DIMENSION); }
 
     if (lex< number >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::NUMBER, lexed); }
+    { return lexed_textual(Textual::NUMBER); }
 
     if (lex< hex >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::HEX, lexed); }
+    { return lexed_textual(Textual::HEX); }
 
     if (peek< string_constant >())
     { return parse_string(); }
 
     if (lex< variable >())
-    { return new (ctx.mem) Variable(path, source_position, lexed); }
+    { return new (ctx.mem) Variable(path, source_position(), lexed); }
 
     error("error reading values after " + lexed.to_string());
 
@@ -1037,29 +1186,74 @@ namespace Sass {
     return 0;
   }
 
+  static double hex_digit(char c)
+  {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return c - 'A' + 10;
+  }
+
+  // numbers and colors are decoded once here rather than every time
+  // they're evaluated
+  Textual* Parser::lexed_textual(Textual::Type type)
+  {
+    using Prelexer::number;
+    Position pos(source_position());
+    string text(lexed.to_string());
+    Textual* txt = new (ctx.mem) Textual(path, pos, type, lexed);
+    switch (type)
+    {
+      case Textual::NUMBER:
+        txt->literal(new (ctx.mem) Number(path, pos, atof(text.c_str())));
+        break;
+      case Textual::PERCENTAGE:
+        txt->literal(new (ctx.mem) Number(path, pos, atof(text.c_str()), "%"));
+        break;
+      case Textual::DIMENSION:
+        txt->literal(new (ctx.mem) Number(path, pos, atof(text.c_str()), Token(number(text.c_str()))));
+        break;
+      case Textual::HEX: {
+        const char* h = text.c_str() + 1; // skip the '#'
+        double r, g, b;
+        if (text.length() == 7) {
+          r = hex_digit(h[0]) * 16 + hex_digit(h[1]);
+          g = hex_digit(h[2]) * 16 + hex_digit(h[3]);
+          b = hex_digit(h[4]) * 16 + hex_digit(h[5]);
+        }
+        else {
+          r = hex_digit(h[0]) * 17;
+          g = hex_digit(h[1]) * 17;
+          b = hex_digit(h[2]) * 17;
+        }
+        txt->literal(new (ctx.mem) Color(path, pos, r, g, b, 1, text));
+      } break;
+    }
+    return txt;
+  }
+
   String* Parser::parse_interpolated_chunk(Token chunk)
   {
     const char* i = chunk.begin;
     // see if there any interpolants
     const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(chunk.begin, chunk.end);
     if (!p) {
-      String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position, chunk);
+      String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position(), chunk);
       str_node->is_delayed(true);
       return str_node;
     }
 
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position());
     schema->quote_mark(*chunk.begin);
     while (i < chunk.end) {
       p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, chunk.end);
       if (p) {
         if (i < p) {
-          (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+          (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, p)); // accumulate the preceding segment if it's nonempty
         }
         const char* j = find_first_in_interval< exactly<rbrace> >(p, chunk.end); // find the closing brace
         if (j) {
           // parse the interpolant and accumulate it
-          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position()).parse_list();
           interp_node->is_interpolant(true);
           (*schema) << interp_node;
           i = j+1;
@@ -1070,7 +1264,7 @@ namespace Sass {
         }
       }
       else { // no interpolants left; add the last segment if nonempty
-        if (i < chunk.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, chunk.end));
+        if (i < chunk.end) (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, chunk.end));
         break;
       }
     }
@@ -1086,23 +1280,23 @@ namespace Sass {
     // // see if there any interpolants
     // const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(str.begin, str.end);
     // if (!p) {
-    //   String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position, str);
+    //   String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position(), str);
     //   str_node->is_delayed(true);
     //   return str_node;
     // }
 
-    // String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    // String_Schema* schema = new (ctx.mem) String_Schema(path, source_position());
     // schema->quote_mark(*str.begin);
     // while (i < str.end) {
     //   p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, str.end);
     //   if (p) {
     //     if (i < p) {
-    //       (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+    //       (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, p)); // accumulate the preceding segment if it's nonempty
     //     }
     //     const char* j = find_first_in_interval< exactly<rbrace> >(p, str.end); // find the closing brace
     //     if (j) {
     //       // parse the interpolant and accumulate it
-    //       Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+    //       Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position()).parse_list();
     //       interp_node->is_interpolant(true);
     //       (*schema) << interp_node;
     //       i = j+1;
@@ -1113,7 +1307,7 @@ namespace Sass {
     //     }
     //   }
     //   else { // no interpolants left; add the last segment if nonempty
-    //     if (i < str.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, str.end));
+    //     if (i < str.end) (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, str.end));
     //     break;
     //   }
     // }
@@ -1130,22 +1324,22 @@ namespace Sass {
     // see if there any interpolants
     const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(str.begin, str.end);
     if (!p) {
-      String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position, str);
+      String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position(), str);
       str_node->is_delayed(true);
       return str_node;
     }
 
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position());
     while (i < str.end) {
       p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, str.end);
       if (p) {
         if (i < p) {
-          (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+          (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, p)); // accumulate the preceding segment if it's nonempty
         }
         const char* j = find_first_in_interval< exactly<rbrace> >(p, str.end); // find the closing brace
         if (j) {
           // parse the interpolant and accumulate it
-          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position()).parse_list();
           interp_node->is_interpolant(true);
           (*schema) << interp_node;
           i = j+1;
@@ -1156,7 +1350,7 @@ namespace Sass {
         }
       }
       else { // no interpolants left; add the last segment if nonempty
-        if (i < str.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, str.end));
+        if (i < str.end) (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, str.end));
         break;
       }
     }
@@ -1165,36 +1359,36 @@ namespace Sass {
 
   String_Schema* Parser::parse_value_schema()
   {
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position());
     size_t num_items = 0;
     while (position < end) {
       if (lex< interpolant >()) {
         Token insides(Token(lexed.begin + 2, lexed.end - 1));
-        Expression* interp_node = Parser::from_token(insides, ctx, path, source_position).parse_list();
+        Expression* interp_node = Parser::from_token(insides, ctx, path, source_position()).parse_list();
         interp_node->is_interpolant(true);
         (*schema) << interp_node;
       }
       else if (lex< identifier >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (ctx.mem) String_Constant(path, source_position(), lexed);
       }
       else if (lex< percentage >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::PERCENTAGE, lexed);
+        (*schema) << lexed_textual(Textual::PERCENTAGE);
       }
       else if (lex< dimension >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::DIMENSION, lexed);
+        (*schema) << lexed_textual(Textual::DIMENSION);
       }
       else if (lex< number >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::NUMBER, lexed);
+        (*schema) << lexed_textual(Textual::NUMBER);
       }
       else if (lex< hex >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::HEX, lexed);
+        (*schema) << lexed_textual(Textual::HEX);
       }
       else if (lex< string_constant >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (ctx.mem) String_Constant(path, source_position(), lexed);
         if (!num_items) schema->quote_mark(*lexed.begin);
       }
       else if (lex< variable >()) {
-        (*schema) << new (ctx.mem) Variable(path, source_position, lexed);
+        (*schema) << new (ctx.mem) Variable(path, source_position(), lexed);
       }
       else {
         error("error parsing interpolated value");
@@ -1206,25 +1400,25 @@ namespace Sass {
 
   String_Schema* Parser::parse_url_schema()
   {
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position());
 
     while (position < end) {
       if (position[0] == '/') {
         lexed = Token(position, position+1);
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (ctx.mem) String_Constant(path, source_position(), lexed);
         ++position;
       }
       else if (lex< interpolant >()) {
         Token insides(Token(lexed.begin + 2, lexed.end - 1));
-        Expression* interp_node = Parser::from_token(insides, ctx, path, source_position).parse_list();
+        Expression* interp_node = Parser::from_token(insides, ctx, path, source_position()).parse_list();
         interp_node->is_interpolant(true);
         (*schema) << interp_node;
       }
       else if (lex< sequence< identifier, exactly<':'> > >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (ctx.mem) String_Constant(path, source_position(), lexed);
       }
       else if (lex< filename >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (ctx.mem) String_Constant(path, source_position(), lexed);
       }
       else {
         error("error parsing interpolated url");
@@ -1241,20 +1435,20 @@ namespace Sass {
     // see if there any interpolants
     const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(id.begin, id.end);
     if (!p) {
-      return new (ctx.mem) String_Constant(path, source_position, id);
+      return new (ctx.mem) String_Constant(path, source_position(), id);
     }
 
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position());
     while (i < id.end) {
       p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, id.end);
       if (p) {
         if (i < p) {
-          (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+          (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, p)); // accumulate the preceding segment if it's nonempty
         }
         const char* j = find_first_in_interval< exactly<rbrace> >(p, id.end); // find the closing brace
         if (j) {
           // parse the interpolant and accumulate it
-          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position()).parse_list();
           interp_node->is_interpolant(true);
           (*schema) << interp_node;
           i = j+1;
@@ -1265,7 +1459,7 @@ namespace Sass {
         }
       }
       else { // no interpolants left; add the last segment if nonempty
-        if (i < id.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, id.end));
+        if (i < id.end) (*schema) << new (ctx.mem) String_Constant(path, source_position(), Token(i, id.end));
         break;
       }
     }
@@ -1276,9 +1470,9 @@ namespace Sass {
   {
     lex< identifier >();
     string name(lexed);
-    Position call_pos = source_position;
+    Position call_pos = source_position();
     lex< exactly<'('> >();
-    Position arg_pos = source_position;
+    Position arg_pos = source_position();
     const char* arg_beg = position;
     parse_list();
     const char* arg_end = position;
@@ -1294,7 +1488,7 @@ namespace Sass {
   {
     lex< identifier >();
     string name(lexed);
-    Position source_position_of_call = source_position;
+    Position source_position_of_call = source_position();
 
     Function_Call* the_call = new (ctx.mem) Function_Call(path, source_position_of_call, name, parse_arguments());
     return the_call;
@@ -1303,7 +1497,7 @@ namespace Sass {
   Function_Call_Schema* Parser::parse_function_call_schema()
   {
     String* name = parse_identifier_schema();
-    Position source_position_of_call = source_position;
+    Position source_position_of_call = source_position();
 
     Function_Call_Schema* the_call = new (ctx.mem) Function_Call_Schema(path, source_position_of_call, name, parse_arguments());
     return the_call;
@@ -1312,7 +1506,7 @@ namespace Sass {
   If* Parser::parse_if_directive(bool else_if)
   {
     lex< if_directive >() || (else_if && lex< exactly<if_after_else_kwd> >());
-    Position if_source_position = source_position;
+    Position if_source_position = source_position();
     Expression* predicate = parse_list();
     predicate->is_delayed(false);
     if (!peek< exactly<'{'> >()) error("expected '{' after the predicate for @if");
@@ -1320,7 +1514,7 @@ namespace Sass {
     Block* alternative = 0;
     if (lex< else_directive >()) {
       if (peek< exactly<if_after_else_kwd> >()) {
-        alternative = new (ctx.mem) Block(path, source_position);
+        alternative = new (ctx.mem) Block(path, source_position());
         (*alternative) << parse_if_directive(true);
       }
       else if (!peek< exactly<'{'> >()) {
@@ -1336,7 +1530,7 @@ namespace Sass {
   For* Parser::parse_for_directive()
   {
     lex< for_directive >();
-    Position for_source_position = source_position;
+    Position for_source_position = source_position();
     if (!lex< variable >()) error("@for directive requires an iteration variable");
     string var(lexed);
     if (!lex< from >()) error("expected 'from' keyword in @for directive");
@@ -1356,7 +1550,7 @@ namespace Sass {
   Each* Parser::parse_each_directive()
   {
     lex < each_directive >();
-    Position each_source_position = source_position;
+    Position each_source_position = source_position();
     if (!lex< variable >()) error("@each directive requires an iteration variable");
     string var(lexed);
     if (!lex< in >()) error("expected 'in' keyword in @each directive");
@@ -1376,7 +1570,7 @@ namespace Sass {
   While* Parser::parse_while_directive()
   {
     lex< while_directive >();
-    Position while_source_position = source_position;
+    Position while_source_position = source_position();
     Expression* predicate = parse_list();
     predicate->is_delayed(false);
     Block* body = parse_block();
@@ -1386,7 +1580,7 @@ namespace Sass {
   Media_Block* Parser::parse_media_block()
   {
     lex< media >();
-    Position media_source_position = source_position;
+    Position media_source_position = source_position();
 
     List* media_queries = parse_media_queries();
 
@@ -1400,7 +1594,7 @@ namespace Sass {
 
   List* Parser::parse_media_queries()
   {
-    List* media_queries = new (ctx.mem) List(path, source_position, 0, List::COMMA);
+    List* media_queries = new (ctx.mem) List(path, source_position(), 0, List::COMMA);
     if (!peek< exactly<'{'> >()) (*media_queries) << parse_media_query();
     while (lex< exactly<','> >()) (*media_queries) << parse_media_query();
     return media_queries;
@@ -1409,13 +1603,13 @@ namespace Sass {
   // Expression* Parser::parse_media_query()
   Media_Query* Parser::parse_media_query()
   {
-    Media_Query* media_query = new (ctx.mem) Media_Query(path, source_position);
+    Media_Query* media_query = new (ctx.mem) Media_Query(path, source_position());
 
     if (lex< exactly< not_kwd > >()) media_query->is_negated(true);
     else if (lex< exactly< only_kwd > >()) media_query->is_restricted(true);
 
     if (peek< identifier_schema >()) media_query->media_type(parse_identifier_schema());
-    else if (lex< identifier >())    media_query->media_type(new (ctx.mem) String_Constant(path, source_position, lexed));
+    else if (lex< identifier >())    media_query->media_type(new (ctx.mem) String_Constant(path, source_position(), lexed));
     else                             (*media_query) << parse_media_expression();
 
     while (lex< exactly< and_kwd > >()) (*media_query) << parse_media_expression();
@@ -1427,7 +1621,7 @@ namespace Sass {
   {
     if (peek< identifier_schema >()) {
       String* ss = parse_identifier_schema();
-      return new (ctx.mem) Media_Query_Expression(path, source_position, ss, 0, true);
+      return new (ctx.mem) Media_Query_Expression(path, source_position(), ss, 0, true);
     }
     if (!lex< exactly<'('> >()) {
       error("media query expression must begin with '('");
@@ -1451,7 +1645,7 @@ namespace Sass {
   {
     lex<at_keyword>();
     string kwd(lexed);
-    Position at_source_position = source_position;
+    Position at_source_position = source_position();
     Selector* sel = 0;
     Expression* val = 0;
     Selector_Lookahead lookahead = lookahead_for_extension_target(position);
@@ -1476,7 +1670,102 @@ namespace Sass {
   Warning* Parser::parse_warning()
   {
     lex< warn >();
-    return new (ctx.mem) Warning(path, source_position, parse_list());
+    return new (ctx.mem) Warning(path, source_position(), parse_list());
+  }
+
+  // Matches the next token the selector lookaheads accept, trying only
+  // the matchers that can start with its first character, in the same
+  // order as they'd be tried one by one, and tells what it is.
+  const char* Parser::peek_selector_token(const char* start, bool hyphens, Selector_Token& token)
+  {
+    const char* p = skip_spaces_and_comments(start);
+    const char* q = 0;
+    Selector_Token::Kind kind = Selector_Token::OTHER;
+    switch (*p) {
+      case '#':
+        if ((q = id_name(p))) kind = Selector_Token::ID_NAME;
+        else (q = sequence< exactly<'#'>, interpolant >(p)) ||
+             (q = interpolant(p));
+        break;
+      case '.':
+        if ((q = class_name(p))) kind = Selector_Token::CLASS_NAME;
+        else (q = percentage(p))                             ||
+             (q = dimension(p))                              ||
+             (q = number(p))                                 ||
+             (q = sequence< exactly<'.'>, interpolant >(p));
+        break;
+      case ':':
+        (q = sequence< pseudo_prefix, identifier >(p))     ||
+        (q = sequence< pseudo_prefix, interpolant >(p));
+        break;
+      case '"': case '\'':
+        q = string_constant(p);
+        break;
+      case '*': case '|':
+        (q = type_selector(p))                             ||
+        (q = exactly<'*'>(p))                              ||
+        (q = dash_match(p));
+        break;
+      case '~': case '>':
+        q = p + 1;
+        kind = Selector_Token::COMBINATOR;
+        break;
+      case ',':
+        q = p + 1;
+        kind = Selector_Token::COMMA;
+        break;
+      case '(': case ')': case '[': case ']': case '&': case '%':
+        q = p + 1;
+        break;
+      case '=':
+        q = exact_match(p);
+        break;
+      case '^':
+        q = prefix_match(p);
+        break;
+      case '$':
+        q = suffix_match(p);
+        break;
+      case '+':
+        if (!((q = percentage(p)) || (q = dimension(p)))) {
+          q = p + 1;
+          kind = Selector_Token::COMBINATOR;
+        }
+        break;
+      case '-':
+        if ((q = identifier(p))) kind = Selector_Token::TYPE_NAME;
+        else (hyphens && (q = hyphens_and_identifier(p)))    ||
+             (q = percentage(p))                             ||
+             (q = dimension(p))                              ||
+             (q = binomial(p))                               ||
+             (q = sequence< optional<sign>,
+                            optional<digits>,
+                            exactly<'n'> >(p))               ||
+             (q = sequence< optional<sign>, digits >(p))     ||
+             (q = number(p))                                 ||
+             (q = sequence< exactly<'-'>, interpolant >(p));
+        break;
+      case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
+        (q = percentage(p))                                ||
+        (q = dimension(p))                                 ||
+        (q = binomial(p))                                  ||
+        (q = sequence< optional<sign>,
+                       optional<digits>,
+                       exactly<'n'> >(p))                  ||
+        (q = sequence< optional<sign>, digits >(p))        ||
+        (q = number(p));
+        break;
+      default:
+        // letters, '_' and '\\' always start an identifier
+        q = identifier(p);
+        kind = Selector_Token::TYPE_NAME;
+        break;
+    }
+    token.begin = p;
+    token.end = q;
+    token.kind = kind;
+    return q;
   }
 
   Selector_Lookahead Parser::lookahead_for_selector(const char* start)
@@ -1485,45 +1774,25 @@ namespace Sass {
     const char* q;
     bool saw_stuff = false;
     bool saw_interpolant = false;
-
-    while ((q = peek< identifier >(p))                             ||
-           (q = peek< hyphens_and_identifier >(p))                 ||
-           (q = peek< type_selector >(p))                          ||
-           (q = peek< id_name >(p))                                ||
-           (q = peek< class_name >(p))                             ||
-           (q = peek< sequence< pseudo_prefix, identifier > >(p))  ||
-           (q = peek< percentage >(p))                             ||
-           (q = peek< dimension >(p))                              ||
-           (q = peek< string_constant >(p))                        ||
-           (q = peek< exactly<'*'> >(p))                           ||
-           (q = peek< exactly<'('> >(p))                           ||
-           (q = peek< exactly<')'> >(p))                           ||
-           (q = peek< exactly<'['> >(p))                           ||
-           (q = peek< exactly<']'> >(p))                           ||
-           (q = peek< exactly<'+'> >(p))                           ||
-           (q = peek< exactly<'~'> >(p))                           ||
-           (q = peek< exactly<'>'> >(p))                           ||
-           (q = peek< exactly<','> >(p))                           ||
-           (q = peek< binomial >(p))                               ||
-           (q = peek< sequence< optional<sign>,
-                                optional<digits>,
-                                exactly<'n'> > >(p))               ||
-           (q = peek< sequence< optional<sign>,
-                                digits > >(p))                     ||
-           (q = peek< number >(p))                                 ||
-           (q = peek< exactly<'&'> >(p))                           ||
-           (q = peek< exactly<'%'> >(p))                           ||
-           (q = peek< alternatives<exact_match,
-                                   class_match,
-                                   dash_match,
-                                   prefix_match,
-                                   suffix_match,
-                                   substring_match> >(p))          ||
-           (q = peek< sequence< exactly<'.'>, interpolant > >(p))  ||
-           (q = peek< sequence< exactly<'#'>, interpolant > >(p))  ||
-           (q = peek< sequence< exactly<'-'>, interpolant > >(p))  ||
-           (q = peek< sequence< pseudo_prefix, interpolant > >(p)) ||
-           (q = peek< interpolant >(p))) {
+    // whether the selector_tokens so far make a plain selector; a comma
+    // can't start one, and a type name can only start a compound selector
+    bool plain = true;
+    Selector_Token token;
+    Selector_Token::Kind last_kind = Selector_Token::COMMA;
+    selector_tokens.clear();
+
+    while ((q = peek_selector_token(p, true, token))) {
+      if (plain) {
+        plain = token.kind != Selector_Token::OTHER &&
+                (saw_stuff ? skip_spaces(p) == token.begin
+                           : token.kind != Selector_Token::COMMA) &&
+                !(token.kind == Selector_Token::TYPE_NAME && token.begin == p &&
+                  (last_kind == Selector_Token::TYPE_NAME ||
+                   last_kind == Selector_Token::CLASS_NAME ||
+                   last_kind == Selector_Token::ID_NAME));
+        if (plain) selector_tokens.push_back(token);
+        last_kind = token.kind;
+      }
       saw_stuff = true;
       p = q;
       if (*(p - 1) == '}') saw_interpolant = true;
@@ -1532,6 +1801,7 @@ namespace Sass {
     Selector_Lookahead result;
     result.found            = saw_stuff && peek< exactly<'{'> >(p) ? p : 0;
     result.has_interpolants = saw_interpolant;
+    result.is_plain         = plain;
 
     return result;
   }
@@ -1542,44 +1812,9 @@ namespace Sass {
     const char* q;
     bool saw_interpolant = false;
     bool saw_stuff = false;
+    Selector_Token token;
 
-    while ((q = peek< identifier >(p))                             ||
-           (q = peek< type_selector >(p))                          ||
-           (q = peek< id_name >(p))                                ||
-           (q = peek< class_name >(p))                             ||
-           (q = peek< sequence< pseudo_prefix, identifier > >(p))  ||
-           (q = peek< percentage >(p))                             ||
-           (q = peek< dimension >(p))                              ||
-           (q = peek< string_constant >(p))                        ||
-           (q = peek< exactly<'*'> >(p))                           ||
-           (q = peek< exactly<'('> >(p))                           ||
-           (q = peek< exactly<')'> >(p))                           ||
-           (q = peek< exactly<'['> >(p))                           ||
-           (q = peek< exactly<']'> >(p))                           ||
-           (q = peek< exactly<'+'> >(p))                           ||
-           (q = peek< exactly<'~'> >(p))                           ||
-           (q = peek< exactly<'>'> >(p))                           ||
-           (q = peek< exactly<','> >(p))                           ||
-           (q = peek< binomial >(p))                               ||
-           (q = peek< sequence< optional<sign>,
-                                optional<digits>,
-                                exactly<'n'> > >(p))               ||
-           (q = peek< sequence< optional<sign>,
-                                digits > >(p))                     ||
-           (q = peek< number >(p))                                 ||
-           (q = peek< exactly<'&'> >(p))                           ||
-           (q = peek< exactly<'%'> >(p))                           ||
-           (q = peek< alternatives<exact_match,
-                                   class_match,
-                                   dash_match,
-                                   prefix_match,
-                                   suffix_match,
-                                   substring_match> >(p))          ||
-           (q = peek< sequence< exactly<'.'>, interpolant > >(p))  ||
-           (q = peek< sequence< exactly<'#'>, interpolant > >(p))  ||
-           (q = peek< sequence< exactly<'-'>, interpolant > >(p))  ||
-           (q = peek< sequence< pseudo_prefix, interpolant > >(p)) ||
-           (q = peek< interpolant >(p))) {
+    while ((q = peek_selector_token(p, false, token))) {
       p = q;
       if (*(p - 1) == '}') saw_interpolant = true;
       saw_stuff = true;
@@ -1588,6 +1823,7 @@ namespace Sass {
     Selector_Lookahead result;
     result.found            = peek< alternatives< exactly<';'>, exactly<'}'>, exactly<'{'> > >(p) && saw_stuff ? p : 0;
     result.has_interpolants = saw_interpolant;
+    result.is_plain         = false;
 
     return result;
   }
@@ -1663,7 +1899,7 @@ namespace Sass {
   Expression* Parser::fold_operands(Expression* base, vector<Expression*>& operands, Binary_Expression::Type op)
   {
     for (size_t i = 0, S = operands.size(); i < S; ++i) {
-      base = new (ctx.mem) Binary_Expression(path, source_position, op, base, operands[i]);
+      base = new (ctx.mem) Binary_Expression(path, source_position(), op, base, operands[i]);
       Binary_Expression* b = static_cast<Binary_Expression*>(base);
       if (op == Binary_Expression::DIV && b->left()->is_delayed() && b->right()->is_delayed()) {
         base->is_delayed(true);
@@ -1694,7 +1930,7 @@ namespace Sass {
 
   void Parser::error(string msg, Position pos)
   {
-    throw Error(Error::syntax, path, pos.line ? pos : source_position, msg);
+    throw Error(Error::syntax, path, pos.line() ? pos : source_position(), msg);
   }
 
 }
@@ -28,6 +28,16 @@
 struct Selector_Lookahead {
   const char* found;
   bool has_interpolants;
+  bool is_plain; // see Parser::selector_tokens
+};
+
+// a token the selector lookaheads match, and what it is when it may
+// appear in a plain selector
+struct Selector_Token {
+  enum Kind { TYPE_NAME, CLASS_NAME, ID_NAME, COMBINATOR, COMMA, OTHER };
+  const char* begin;
+  const char* end;
+  Kind kind;
 };
 
 namespace Sass {
@@ -42,27 +52,61 @@ namespace Sass {
 
     enum Syntactic_Context { nothing, mixin_def, function_def };
 
+    // the statement directives, as told apart by lookup_directive
+    enum Directive { no_directive,
+                     at_import, at_mixin, at_function, at_return, at_include,
+                     at_content, at_extend, at_if, at_for, at_each, at_while,
+                     at_warn, at_media, at_charset,
+                     at_other };
+
     Context& ctx;
     vector<Syntactic_Context> stack;
     const char* source;
     const char* position;
     const char* end;
     string path;
-    size_t column;
-    Position source_position;
+    Position start_position; // of the source, when it's part of a bigger one
+
+    // the newline index of the stylesheet this source is or is part of; nodes
+    // record offsets into it, and their lines and columns are worked out
+    // only when an error, a source comment or a source map asks for them
+    Line_Index* line_index;
+
+    // text without an index (made during evaluation, say) has the line of
+    // the current position worked out as nodes ask for it, by counting the
+    // newlines from where it was last worked out
+    const char* line_cursor;
+    const char* line_begin; // the first character of line_cursor's line
+    size_t line;
 
 
     Token lexed;
 
-    Parser(Context& ctx, string path, Position source_position)
+    // where the last spaces_and_comments skip started and ended; the
+    // statement dispatch peeks many tokens from the same position, so
+    // this saves scanning the same whitespace and comments again
+    const char* trivia_begin;
+    const char* trivia_end;
+
+    // the tokens of the last selector lookahead_for_selector found, when
+    // it's plain: nothing but type, class and id names, combinators and
+    // commas, with only spaces between them; the ruleset is built out of
+    // them rather than by lexing the selector again
+    vector<Selector_Token> selector_tokens;
+
+    Parser(Context& ctx, string path, Position start_position)
     : ctx(ctx), stack(vector<Syntactic_Context>()),
-      source(0), position(0), end(0), path(path), column(1), source_position(source_position)
+      source(0), position(0), end(0), path(path), start_position(start_position),
+      line_index(0), line_cursor(0), line_begin(0), line(0),
+      trivia_begin(0), trivia_end(0), selector_tokens(vector<Selector_Token>())
     { stack.push_back(nothing); }
 
     static Parser from_string(string src, Context& ctx, string path = "", Position source_position = Position());
     static Parser from_c_str(const char* src, Context& ctx, string path = "", Position source_position = Position());
     static Parser from_token(Token t, Context& ctx, string path = "", Position source_position = Position());
 
+    void index_lines();
+
 #ifdef __clang__
 
     // lex and peak uses the template parameter to branch on the action, which
@@ -75,6 +119,46 @@ namespace Sass {
 
 #endif
 
+    // The position of the last lexed token: the line of the current
+    // position (so the last line of the token), and the column the
+    // token starts at.
+    Position source_position()
+    {
+      if (!lexed.begin) return start_position;
+      if (line_index) {
+        const char* indexed = line_index->source();
+        return Position(start_position.file, line_index, lexed.begin - indexed, position - indexed);
+      }
+      if (position < line_cursor || !line_cursor) {
+        line_cursor = line_begin = source;
+        line = start_position.line();
+      }
+      if (line_cursor < position) {
+        unsigned int newlines = count_interval<'\n'>(line_cursor, position);
+        if (newlines) {
+          line += newlines;
+          line_begin = position;
+          while (line_begin[-1] != '\n') --line_begin;
+        }
+        line_cursor = position;
+      }
+      const char* token_line = line_begin;
+      if (lexed.begin < line_begin) {
+        token_line = lexed.begin;
+        while (token_line > source && token_line[-1] != '\n') --token_line;
+      }
+      return Position(start_position.file, line, lexed.begin - token_line + 1);
+    }
+
+    const char* skip_spaces_and_comments(const char* start)
+    {
+      if (start != trivia_begin) {
+        trivia_begin = start;
+        trivia_end = spaces_and_comments(start);
+      }
+      return trivia_end;
+    }
+
     template <prelexer mx>
     const char* peek(const char* start = 0)
     {
@@ -103,7 +187,7 @@ namespace Sass {
         after_whitespace = position;
       }
       else {
-        after_whitespace = spaces_and_comments(start);
+        after_whitespace = skip_spaces_and_comments(start);
       }
       const char* after_token = mx(after_whitespace);
       if (after_token) {
@@ -131,7 +215,6 @@ namespace Sass {
       else if (mx == spaces) {
         after_whitespace = spaces(position);
         if (after_whitespace) {
-          source_position.line += count_interval<'\n'>(position, after_whitespace);
           lexed = Token(position, after_whitespace);
           return position = after_whitespace;
         }
@@ -143,27 +226,10 @@ namespace Sass {
         after_whitespace = optional_spaces(position);
       }
       else {
-        after_whitespace = spaces_and_comments(position);
+        after_whitespace = skip_spaces_and_comments(position);
       }
       const char* after_token = mx(after_whitespace);
       if (after_token) {
-        size_t previous_line = source_position.line;
-        source_position.line += count_interval<'\n'>(position, after_token);
-
-        size_t whitespace = 0;
-        const char* ptr = after_whitespace - 1;
-        while (ptr >= position) {
-          if (*ptr == '\n')
-            break;
-          whitespace++;
-          ptr--;
-        }
-        if (previous_line != source_position.line) {
-          column = 1;
-        }
-
-        source_position.column = column + whitespace;
-        column += after_token - after_whitespace + whitespace;
         lexed = Token(after_whitespace, after_token);
 
         return position = after_token;
@@ -197,6 +263,11 @@ namespace Sass {
     Selector_List* parse_selector_group();
     Complex_Selector* parse_selector_combination();
     Compound_Selector* parse_simple_selector_sequence();
+    Selector_List* parse_plain_selector_group();
+    Complex_Selector* parse_plain_selector_combination(const Selector_Token*& token, const Selector_Token* last);
+    Compound_Selector* parse_plain_selector_sequence(const Selector_Token*& token, const Selector_Token* last);
+    void lex_selector_token(const Selector_Token*& token);
+    Complex_Selector* add_parent_reference(Complex_Selector* comb);
     Simple_Selector* parse_simple_selector();
     Negated_Selector* parse_negated_selector();
     Pseudo_Selector* parse_pseudo_selector();
@@ -213,6 +284,7 @@ namespace Sass {
     Expression* parse_term();
     Expression* parse_factor();
     Expression* parse_value();
+    Textual* lexed_textual(Textual::Type);
     Function_Call* parse_calc_function();
     Function_Call* parse_function_call();
     Function_Call_Schema* parse_function_call_schema();
@@ -233,6 +305,8 @@ namespace Sass {
     At_Rule* parse_at_rule();
     Warning* parse_warning();
 
+    Directive lookup_directive(const char* start);
+    const char* peek_selector_token(const char* start, bool hyphens, Selector_Token& token);
     Selector_Lookahead lookahead_for_selector(const char* start = 0);
     Selector_Lookahead lookahead_for_extension_target(const char* start = 0);
 
@@ -0,0 +1,30 @@
+#include <algorithm>
+
+#ifndef SASS_POSITION
+#include "position.hpp"
+#endif
+
+#ifndef SASS_PRELEXER
+#include "prelexer.hpp"
+#endif
+
+namespace Sass {
+
+  void Line_Index::scan()
+  {
+    line_begins.push_back(0);
+    for (const char* p = Prelexer::find_char(source_, '\n'); p < end_ && *p; p = Prelexer::find_char(p + 1, '\n')) {
+      line_begins.push_back(p + 1 - source_);
+    }
+  }
+
+  size_t Line_Index::line(size_t offset)
+  {
+    if (line_begins.empty()) scan();
+    return std::upper_bound(line_begins.begin(), line_begins.end(), offset) - line_begins.begin();
+  }
+
+  size_t Line_Index::column(size_t offset)
+  { return offset - line_begins[line(offset) - 1] + 1; }
+
+}
@@ -1,22 +1,57 @@
 #define SASS_POSITION
 
 #include <cstdlib>
+#include <vector>
 
 namespace Sass {
+  using std::vector;
 
-  struct Position {
+  // The offsets at which the lines of a source begin, found with a single
+  // newline scan the first time a line or column in it is asked for.
+  class Line_Index {
+    const char* source_;
+    const char* end_;
+    vector<size_t> line_begins;
+
+    void scan();
+
+  public:
+    Line_Index(const char* source, const char* end) : source_(source), end_(end) { }
+
+    const char* source() const { return source_; }
+    bool contains(const char* p) const { return source_ <= p && p <= end_; }
+
+    size_t line(size_t offset);   // 1-based
+    size_t column(size_t offset); // 1-based
+  };
+
+  class Position {
+    Line_Index* index;
+    // with an index, these are the offsets the line and the column are
+    // worked out from, rather than the line and column themselves
+    size_t line_;
+    size_t column_;
+
+  public:
     size_t file;
-    size_t line;
-    size_t column;
 
     Position()
-    : file(0), line(0), column(0) { }
+    : index(0), line_(0), column_(0), file(0) { }
 
     Position(const size_t file, const size_t line, const size_t column)
-    : file(file), line(line), column(column) { }
+    : index(0), line_(line), column_(column), file(file) { }
 
     Position(const size_t line, const size_t column)
-    : file(0), line(line), column(column) { }
+    : index(0), line_(line), column_(column), file(0) { }
+
+    // the line of the offset `end`, and the column of the offset `begin`
+    Position(const size_t file, Line_Index* index, const size_t begin, const size_t end)
+    : index(index), line_(end), column_(begin), file(file) { }
+
+    size_t line() const   { return index ? index->line(line_) : line_; }
+    size_t column() const { return index ? index->column(column_) : column_; }
+
+    Line_Index* line_index() const { return index; }
   };
 
 }
@@ -3,6 +3,14 @@
 #include "constants.hpp"
 #include "prelexer.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SASS_PRELEXER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 
 namespace Sass {
   using namespace Constants;
@@ -21,20 +29,182 @@ namespace Sass {
     // Match any single character.
     const char* any_char(const char* src) { return *src ? src+1 : src; }
 
-    // Match a single character satisfying the ctype predicates.
-    const char* space(const char* src) { return std::isspace(*src) ? src+1 : 0; }
-    const char* alpha(const char* src) { return std::isalpha(*src) || !isascii(*src) ? src+1 : 0; }
-    const char* digit(const char* src) { return std::isdigit(*src) ? src+1 : 0; }
-    const char* xdigit(const char* src) { return std::isxdigit(*src) ? src+1 : 0; }
-    const char* alnum(const char* src) { return std::isalnum(*src) || !isascii(*src) ? src+1 : 0; }
-    const char* punct(const char* src) { return std::ispunct(*src) ? src+1 : 0; }
-    // Match multiple ctype characters.
-    const char* spaces(const char* src) { return one_plus<space>(src); }
-    const char* alphas(const char* src) { return one_plus<alpha>(src); }
-    const char* digits(const char* src) { return one_plus<digit>(src); }
-    const char* xdigits(const char* src) { return one_plus<xdigit>(src); }
-    const char* alnums(const char* src) { return one_plus<alnum>(src); }
-    const char* puncts(const char* src) { return one_plus<punct>(src); }
+    // Bytes 0x80-0xff are all ALPHA_CLASS and NMSTART_CLASS, so that
+    // identifiers may contain any UTF-8 sequence.
+#define SP SPACE_CLASS
+#define PU PUNCT_CLASS
+#define DI (DIGIT_CLASS | XDIGIT_CLASS | NAME_CLASS)
+#define HX (ALPHA_CLASS | XDIGIT_CLASS | NMSTART_CLASS | NAME_CLASS)
+#define AL (ALPHA_CLASS | NMSTART_CLASS | NAME_CLASS)
+#define HY (PUNCT_CLASS | NAME_CLASS)
+#define US (PUNCT_CLASS | NMSTART_CLASS | NAME_CLASS)
+    const unsigned char char_classes[256] = {
+        0,  0,  0,  0,  0,  0,  0,  0,  0, SP, SP, SP, SP, SP,  0,  0,  // 0x00
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 0x10
+       SP, PU, PU, PU, PU, PU, PU, PU, PU, PU, PU, PU, PU, HY, PU, PU,  // 0x20
+       DI, DI, DI, DI, DI, DI, DI, DI, DI, DI, PU, PU, PU, PU, PU, PU,  // 0x30
+       PU, HX, HX, HX, HX, HX, HX, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0x40
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, PU, PU, PU, PU, US,  // 0x50
+       PU, HX, HX, HX, HX, HX, HX, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0x60
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, PU, PU, PU, PU,  0,  // 0x70
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0x80
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0x90
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0xa0
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0xb0
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0xc0
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0xd0
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0xe0
+       AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  // 0xf0
+    };
+#undef SP
+#undef PU
+#undef DI
+#undef HX
+#undef AL
+#undef HY
+#undef US
+
+    // Bytes 0x80-0xff are in none of them.
+#define SG SIGN_CHARS
+#define UR URL_SPACE_CHARS
+#define ES ESCAPE_CHARS
+#define UE (URL_SPACE_CHARS | ESCAPE_CHARS)
+#define SE (SIGN_CHARS | ESCAPE_CHARS)
+    const unsigned char class_string_classes[256] = {
+        0,  0,  0,  0,  0,  0,  0,  0,  0, UR, UR,  0, UR, UR,  0,  0,  // 0x00
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 0x10
+       UE,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, SG,  0, SE,  0,  0,  // 0x20
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 0x30
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 0x40
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 0x50
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 0x60
+        0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, ES,  0,  // 0x70
+    };
+#undef SG
+#undef UR
+#undef ES
+#undef UE
+#undef SE
+
+#ifdef SASS_PRELEXER_SSE2
+    // The kernels below only do aligned 16-byte loads, which never cross
+    // a page boundary, so they may safely read past the terminating null
+    // (and before src) within the block that contains it.
+
+    static inline unsigned int first_bit(unsigned int mask) {
+#ifdef _MSC_VER
+      unsigned long i;
+      _BitScanForward(&i, mask);
+      return i;
+#else
+      return __builtin_ctz(mask);
+#endif
+    }
+
+    static inline unsigned int bit_count(unsigned int mask) {
+      unsigned int counter = 0;
+      for (; mask; mask &= mask - 1) ++counter;
+      return counter;
+    }
+
+    const char* skip_spaces(const char* src) {
+      if (!(char_classes[(unsigned char)*src] & SPACE_CLASS)) return src;
+      const __m128i blank = _mm_set1_epi8(' ');
+      const __m128i tab = _mm_set1_epi8('\t');
+      const __m128i four = _mm_set1_epi8(4);
+      size_t offset = (size_t)src & 15;
+      const char* block = src - offset;
+      unsigned int skip = (0xffffu << offset) & 0xffffu;
+      while (1) {
+        __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        // '\t' through '\r' are the bytes where (x - '\t') <= 4, unsigned
+        __m128i t = _mm_sub_epi8(x, tab);
+        __m128i sp = _mm_or_si128(_mm_cmpeq_epi8(x, blank),
+                                  _mm_cmpeq_epi8(_mm_min_epu8(t, four), t));
+        unsigned int mask = ~_mm_movemask_epi8(sp) & skip;
+        if (mask) return block + first_bit(mask);
+        block += 16;
+        skip = 0xffffu;
+      }
+    }
+
+    const char* find_char(const char* src, char c) {
+      const __m128i needle = _mm_set1_epi8(c);
+      const __m128i zero = _mm_setzero_si128();
+      size_t offset = (size_t)src & 15;
+      const char* block = src - offset;
+      unsigned int skip = (0xffffu << offset) & 0xffffu;
+      while (1) {
+        __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, needle),
+                                                           _mm_cmpeq_epi8(x, zero))) & skip;
+        if (mask) return block + first_bit(mask);
+        block += 16;
+        skip = 0xffffu;
+      }
+    }
+
+    unsigned int count_char(const char* beg, const char* end, char c) {
+      unsigned int counter = 0;
+      while (beg < end && ((size_t)beg & 15)) {
+        if (!*beg) return counter;
+        if (*beg == c) ++counter;
+        ++beg;
+      }
+      const __m128i needle = _mm_set1_epi8(c);
+      const __m128i zero = _mm_setzero_si128();
+      while (end - beg >= 16) {
+        __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(beg));
+        unsigned int found = _mm_movemask_epi8(_mm_cmpeq_epi8(x, needle));
+        unsigned int nulls = _mm_movemask_epi8(_mm_cmpeq_epi8(x, zero));
+        if (nulls) return counter + bit_count(found & ((nulls & -nulls) - 1));
+        counter += bit_count(found);
+        beg += 16;
+      }
+      while (beg < end && *beg) {
+        if (*beg == c) ++counter;
+        ++beg;
+      }
+      return counter;
+    }
+#else
+    const char* skip_spaces(const char* src) {
+      while (char_classes[(unsigned char)*src] & SPACE_CLASS) ++src;
+      return src;
+    }
+
+    const char* find_char(const char* src, char c) {
+      while (*src && *src != c) ++src;
+      return src;
+    }
+
+    unsigned int count_char(const char* beg, const char* end, char c) {
+      unsigned int counter = 0;
+      while (beg < end && *beg) {
+        if (*beg == c) ++counter;
+        ++beg;
+      }
+      return counter;
+    }
+#endif
+
+    // Match a single character of the character classes.
+    const char* space(const char* src) { return class_char<SPACE_CLASS>(src); }
+    const char* alpha(const char* src) { return class_char<ALPHA_CLASS>(src); }
+    const char* digit(const char* src) { return class_char<DIGIT_CLASS>(src); }
+    const char* xdigit(const char* src) { return class_char<XDIGIT_CLASS>(src); }
+    const char* alnum(const char* src) { return class_char<ALNUM_CLASS>(src); }
+    const char* punct(const char* src) { return class_char<PUNCT_CLASS>(src); }
+    // Match multiple characters of the character classes.
+    const char* spaces(const char* src) {
+      const char* p = skip_spaces(src);
+      return p == src ? 0 : p;
+    }
+    const char* alphas(const char* src) { return class_chars<ALPHA_CLASS>(src); }
+    const char* digits(const char* src) { return class_chars<DIGIT_CLASS>(src); }
+    const char* xdigits(const char* src) { return class_chars<XDIGIT_CLASS>(src); }
+    const char* alnums(const char* src) { return class_chars<ALNUM_CLASS>(src); }
+    const char* puncts(const char* src) { return class_chars<PUNCT_CLASS>(src); }
 
     // Match a line comment.
     const char* line_comment(const char* src) { return to_endl<slash_slash>(src); }
@@ -74,7 +244,9 @@ namespace Sass {
     const char* optional_spaces(const char* src) { return optional<spaces>(src); }
     const char* optional_comment(const char* src) { return optional<comment>(src); }
     const char* spaces_and_comments(const char* src) {
-      return zero_plus< alternatives<spaces, comment> >(src);
+      const char* p;
+      while ((p = comment(src = skip_spaces(src)))) src = p;
+      return src;
     }
     const char* no_spaces(const char* src) {
       return negate< spaces >(src);
@@ -85,13 +257,23 @@ namespace Sass {
     }
 
     // Match CSS identifiers.
+    // The hot token matchers below scan in a single pass over the
+    // char_classes table; their combinator definitions are kept in
+    // Prelexer::Reference (at the end of this file) to test them against.
+    static inline const char* name_chars(const char* p) {
+      while (1) {
+        if (char_classes[(unsigned char)*p] & NAME_CLASS) ++p;
+        else if (*p == '\\') p += p[1] ? 2 : 1;
+        else return p;
+      }
+    }
     const char* identifier(const char* src) {
-      return sequence< optional< exactly<'-'> >,
-                       alternatives< alpha, exactly<'_'>, backslash_something >,
-                       zero_plus< alternatives< alnum,
-                                                exactly<'-'>,
-                                                exactly<'_'>,
-                                                backslash_something > > >(src);
+      const char* p = src;
+      if (*p == '-') ++p;
+      if (char_classes[(unsigned char)*p] & NMSTART_CLASS) ++p;
+      else if (*p == '\\') p += p[1] ? 2 : 1;
+      else return 0;
+      return name_chars(p);
     }
 
     // Match CSS selectors.
@@ -220,9 +402,7 @@ namespace Sass {
     }
 
     const char* name(const char* src) {
-      return one_plus< alternatives< alnum,
-                                     exactly<'-'>,
-                                     exactly<'_'> > >(src);
+      return class_chars<NAME_CLASS>(src);
     }
 
     const char* warn(const char* src) {
@@ -274,13 +454,16 @@ namespace Sass {
       return class_char<sign_chars>(src);
     }
     const char* unsigned_number(const char* src) {
-      return alternatives<sequence< zero_plus<digits>,
-                                    exactly<'.'>,
-                                    one_plus<digits> >,
-                          digits>(src);
+      const char* p = src;
+      while (char_classes[(unsigned char)*p] & DIGIT_CLASS) ++p;
+      if (*p == '.' && (char_classes[(unsigned char)p[1]] & DIGIT_CLASS)) {
+        p += 2;
+        while (char_classes[(unsigned char)*p] & DIGIT_CLASS) ++p;
+      }
+      return p == src ? 0 : p;
     }
     const char* number(const char* src) {
-      return sequence< optional<sign>, unsigned_number>(src);
+      return unsigned_number(*src == '-' || *src == '+' ? src + 1 : src);
     }
     const char* coefficient(const char* src) {
       return alternatives< sequence< optional<sign>, digits >,
@@ -304,7 +487,9 @@ namespace Sass {
       return sequence<number, identifier>(src);
     }
     const char* hex(const char* src) {
-      const char* p = sequence< exactly<'#'>, one_plus<xdigit> >(src);
+      if (*src != '#') return 0;
+      const char* p = src + 1;
+      while (char_classes[(unsigned char)*p] & XDIGIT_CLASS) ++p;
       int len = p - src;
       return (len != 4 && len != 7) ? 0 : p;
     }
@@ -495,7 +680,7 @@ namespace Sass {
     }
 
     const char* H(const char* src) {
-      return std::isxdigit(*src) ? src+1 : 0;
+      return class_char<XDIGIT_CLASS>(src);
     }
 
     const char* unicode(const char* src) {
@@ -529,5 +714,38 @@ namespace Sass {
       }
       return pos;
     }
+
+    // The combinator definitions of the token matchers that scan in a
+    // single pass above, to differentially test them against.
+    namespace Reference {
+      const char* identifier(const char* src) {
+        return sequence< optional< exactly<'-'> >,
+                         alternatives< alpha, exactly<'_'>, backslash_something >,
+                         zero_plus< alternatives< alnum,
+                                                  exactly<'-'>,
+                                                  exactly<'_'>,
+                                                  backslash_something > > >(src);
+      }
+      const char* name(const char* src) {
+        return one_plus< alternatives< alnum,
+                                       exactly<'-'>,
+                                       exactly<'_'> > >(src);
+      }
+      const char* unsigned_number(const char* src) {
+        return alternatives<sequence< zero_plus<digits>,
+                                      exactly<'.'>,
+                                      one_plus<digits> >,
+                            digits>(src);
+      }
+      const char* number(const char* src) {
+        return sequence< optional<sign>, unsigned_number>(src);
+      }
+      const char* hex(const char* src) {
+        const char* p = sequence< exactly<'#'>, one_plus<xdigit> >(src);
+        if (!p) return 0;
+        int len = p - src;
+        return (len != 4 && len != 7) ? 0 : p;
+      }
+    }
   }
 }
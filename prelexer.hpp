@@ -1,5 +1,9 @@
 #define SASS_PRELEXER
 
+#ifndef SASS_CONSTANTS
+#include "constants.hpp"
+#endif
+
 namespace Sass {
   namespace Prelexer {
 
@@ -20,6 +24,66 @@ namespace Sass {
       return *pre ? 0 : src;
     }
 
+    // Bit flags of the character classes in the char_classes table.
+    enum Char_Class {
+      SPACE_CLASS   = 1 << 0,
+      ALPHA_CLASS   = 1 << 1, // ASCII letters, and any non-ASCII byte
+      DIGIT_CLASS   = 1 << 2,
+      XDIGIT_CLASS  = 1 << 3,
+      PUNCT_CLASS   = 1 << 4,
+      NMSTART_CLASS = 1 << 5, // may start an identifier: alpha and '_'
+      NAME_CLASS    = 1 << 6, // may continue one: alnum, '-' and '_'
+      ALNUM_CLASS   = ALPHA_CLASS | DIGIT_CLASS
+    };
+
+    // The classes of each byte, indexed by unsigned char.  Unlike the
+    // ctype functions they don't depend on the locale, and are safe to
+    // use with negative chars.
+    extern const unsigned char char_classes[256];
+
+    // Match a single character that is in any of the supplied classes.
+    template <Char_Class cls>
+    const char* class_char(const char* src) {
+      return char_classes[(unsigned char)*src] & cls ? src + 1 : 0;
+    }
+
+    // Match a sequence of characters that are all in the supplied classes.
+    template <Char_Class cls>
+    const char* class_chars(const char* src) {
+      const char* p = src;
+      while (char_classes[(unsigned char)*p] & cls) ++p;
+      return p == src ? 0 : p;
+    }
+
+    // Scanning kernels, vectorized with SSE2 where it's available.
+    // Return the first character at or after src that isn't a space.
+    const char* skip_spaces(const char* src);
+    // Return the first occurrence of c at or after src, or the
+    // terminating null if there's none.
+    const char* find_char(const char* src, char c);
+    // Count the occurrences of c in [beg, end), up to a null.
+    unsigned int count_char(const char* beg, const char* end, char c);
+
+    // Bit flags of the constant class strings (sign_chars, ...) in the
+    // class_string_classes table.
+    enum Class_String_Class {
+      SIGN_CHARS      = 1 << 0,
+      URL_SPACE_CHARS = 1 << 1,
+      ESCAPE_CHARS    = 1 << 2
+    };
+
+    // The class strings of each byte, indexed by unsigned char.
+    extern const unsigned char class_string_classes[256];
+
+    // The flag of a class string; matching any class string that isn't
+    // specialized here doesn't compile.
+    template <const char* char_class>
+    struct Class_String;
+
+    template <> struct Class_String<Constants::sign_chars>      { enum { flag = SIGN_CHARS }; };
+    template <> struct Class_String<Constants::url_space_chars> { enum { flag = URL_SPACE_CHARS }; };
+    template <> struct Class_String<Constants::escape_chars>    { enum { flag = ESCAPE_CHARS }; };
+
     // Match a single character that satifies the supplied ctype predicate.
     template <ctype_predicate pred>
     const char* class_char(const char* src) {
@@ -29,9 +93,7 @@ namespace Sass {
     // Match a single character that is a member of the supplied class.
     template <const char* char_class>
     const char* class_char(const char* src) {
-      const char* cc = char_class;
-      while (*cc && *src != *cc) ++cc;
-      return *cc ? src + 1 : 0;
+      return class_string_classes[(unsigned char)*src] & Class_String<char_class>::flag ? src + 1 : 0;
     }
 
     // Match a sequence of characters that all satisfy the supplied ctype predicate.
@@ -46,7 +108,7 @@ namespace Sass {
     template <const char* char_class>
     const char* class_chars(const char* src) {
       const char* p = src;
-      while (class_char<char_class>(p)) ++p;
+      while (class_string_classes[(unsigned char)*p] & Class_String<char_class>::flag) ++p;
       return p == src ? 0 : p;
     }
 
@@ -54,8 +116,7 @@ namespace Sass {
     template <const char* prefix>
     const char* to_endl(const char* src) {
       if (!(src = exactly<prefix>(src))) return 0;
-      while (*src && *src != '\n') ++src;
-      return src;
+      return find_char(src, '\n');
     }
 
     // Match a sequence of characters delimited by the supplied chars.
@@ -63,12 +124,11 @@ namespace Sass {
     const char* delimited_by(const char* src) {
       src = exactly<beg>(src);
       if (!src) return 0;
-      const char* stop;
       while (1) {
+        src = find_char(src, end);
         if (!*src) return 0;
-        stop = exactly<end>(src);
-        if (stop && (!esc || *(src - 1) != '\\')) return stop;
-        src = stop ? stop : src + 1;
+        if (!esc || *(src - 1) != '\\') return src + 1;
+        ++src;
       }
     }
 
@@ -79,6 +139,7 @@ namespace Sass {
       if (!src) return 0;
       const char* stop;
       while (1) {
+        src = find_char(src, *end);
         if (!*src) return 0;
         stop = exactly<end>(src);
         if (stop && (!esc || *(src - 1) != '\\')) return stop;
@@ -322,6 +383,8 @@ namespace Sass {
 
     // Match a CSS identifier.
     const char* identifier(const char* src);
+    // Match the name of an id or a variable.
+    const char* name(const char* src);
     // Match selector names.
     const char* sel_ident(const char* src);
     // Match interpolant schemas
@@ -450,7 +513,7 @@ namespace Sass {
     // Utility functions for finding and counting characters in a string.
     template<char c>
     const char* find_first(const char* src) {
-      while (*src && *src != c) ++src;
+      src = find_char(src, c);
       return *src ? src : 0;
     }
     template<prelexer mx>
@@ -468,12 +531,7 @@ namespace Sass {
     }
     template <char c>
     unsigned int count_interval(const char* beg, const char* end) {
-      unsigned int counter = 0;
-      while (beg < end && *beg) {
-        if (*beg == c) ++counter;
-        ++beg;
-      }
-      return counter;
+      return count_char(beg, end, c);
     }
     template <prelexer mx>
     unsigned int count_interval(const char* beg, const char* end) {
@@ -492,5 +550,15 @@ namespace Sass {
     }
 
     const char* chunk(const char* src);
+
+    // The combinator definitions of the token matchers that scan in a
+    // single pass, kept to differentially test them against.
+    namespace Reference {
+      const char* identifier(const char* src);
+      const char* name(const char* src);
+      const char* unsigned_number(const char* src);
+      const char* number(const char* src);
+      const char* hex(const char* src);
+    }
   }
 }
@@ -4,6 +4,18 @@
 #include <Python.h>
 #include "sass_interface.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
 #if PY_MAJOR_VERSION >= 3
 #define PySass_IF_PY3(three, two) (three)
 #define PySass_Int_FromLong(v) PyLong_FromLong(v)
@@ -18,6 +30,14 @@
 #define PySass_Bytes_AS_STRING(o) PyString_AS_STRING(o)
 #endif
 
+#ifdef _WIN32
+#define PySass_Atomic_Next(p) (InterlockedIncrement(p) - 1)
+typedef LONG PySass_Counter;
+#else
+#define PySass_Atomic_Next(p) __sync_fetch_and_add((p), 1)
+typedef long PySass_Counter;
+#endif
+
 struct PySass_Pair {
     char *label;
     int value;
@@ -39,6 +59,123 @@ static struct PySass_Pair PySass_source_comments_enum[] = {
     {NULL}
 };
 
+static PyObject *
+PySass_make_import_graph(struct sass_import_graph_entry *graph, int size) {
+    PyObject *result, *imports, *entry;
+    int i, j;
+
+    result = PyList_New(0);
+    for (i = 0; result != NULL && i < size; ++i) {
+        imports = PyTuple_New(graph[i].num_imports);
+        for (j = 0; imports != NULL && j < graph[i].num_imports; ++j) {
+            PyTuple_SET_ITEM(imports, j,
+                             PySass_Int_FromLong((long) graph[i].imports[j]));
+        }
+        entry = Py_BuildValue(PySass_IF_PY3("yyN", "ssN"),
+                              graph[i].path, graph[i].hash, imports);
+        if (entry == NULL || PyList_Append(result, entry)) {
+            Py_CLEAR(result);
+        }
+        Py_XDECREF(entry);
+    }
+    return result;
+}
+
+/* SourceCache objects keep the files loaded by the compiles of files
+   they're passed to, so that long-lived compilers like sassc --watch
+   don't read and convert the unchanged ones again.  They're only used
+   by compile_filename(), which holds the GIL, so no two compiles ever
+   use one at a time. */
+typedef struct {
+    PyObject_HEAD
+    struct sass_source_cache *cache;
+} PySass_SourceCache;
+
+static PyObject *
+PySass_SourceCache_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    PySass_SourceCache *self;
+
+    if (!PyArg_ParseTuple(args, ":SourceCache")) {
+        return NULL;
+    }
+    self = (PySass_SourceCache *) type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->cache = sass_new_source_cache();
+    if (self->cache == NULL) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *) self;
+}
+
+static void
+PySass_SourceCache_dealloc(PySass_SourceCache *self) {
+    if (self->cache != NULL) {
+        sass_free_source_cache(self->cache);
+    }
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *
+PySass_SourceCache_forget(PySass_SourceCache *self, PyObject *args) {
+    char *path;
+
+    if (!PyArg_ParseTuple(args, PySass_IF_PY3("y", "s"), &path)) {
+        return NULL;
+    }
+    sass_source_cache_forget(self->cache, path);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef PySass_SourceCache_methods[] = {
+    {"forget", (PyCFunction) PySass_SourceCache_forget, METH_VARARGS,
+     "Drop a file from the cache."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject PySass_SourceCacheType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_sass.SourceCache",                        /* tp_name */
+    sizeof(PySass_SourceCache),                 /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor) PySass_SourceCache_dealloc,    /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_compare */
+    0,                                          /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    "Files loaded by compiles, kept across them.", /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    PySass_SourceCache_methods,                 /* tp_methods */
+    0,                                          /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    PySass_SourceCache_new                      /* tp_new */
+};
+
 static PyObject *
 PySass_compile_string(PyObject *self, PyObject *args) {
     struct sass_context *context;
@@ -63,9 +200,11 @@ PySass_compile_string(PyObject *self, PyObject *args) {
     sass_compile(context);
 
     result = Py_BuildValue(
-        PySass_IF_PY3("hy", "hs"),
+        PySass_IF_PY3("hyN", "hsN"),
         (short int) !context->error_status,
-        context->error_status ? context->error_message : context->output_string
+        context->error_status ? context->error_message : context->output_string,
+        PySass_make_import_graph(context->import_graph,
+                                 context->num_import_graph_entries)
     );
     sass_free_context(context);
     return result;
@@ -76,12 +215,19 @@ PySass_compile_filename(PyObject *self, PyObject *args) {
     struct sass_file_context *context;
     char *filename, *include_paths, *image_path;
     int output_style, source_comments, error_status;
-    PyObject *source_map_filename, *result;
+    PyObject *source_map_filename, *source_cache = Py_None, *result;
 
     if (!PyArg_ParseTuple(args,
-                          PySass_IF_PY3("yiiyyO", "siissO"),
+                          PySass_IF_PY3("yiiyyO|O", "siissO|O"),
                           &filename, &output_style, &source_comments,
-                          &include_paths, &image_path, &source_map_filename)) {
+                          &include_paths, &image_path, &source_map_filename,
+                          &source_cache)) {
+        return NULL;
+    }
+    if (source_cache != Py_None &&
+        !PyObject_TypeCheck(source_cache, &PySass_SourceCacheType)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "source_cache must be a SourceCache or None");
         return NULL;
     }
 
@@ -104,17 +250,23 @@ PySass_compile_filename(PyObject *self, PyObject *args) {
     context->options.source_comments = source_comments;
     context->options.include_paths = include_paths;
     context->options.image_path = image_path;
+    if (source_cache != Py_None) {
+        context->source_cache =
+            ((PySass_SourceCache *) source_cache)->cache;
+    }
 
     sass_compile_file(context);
 
     error_status = context->error_status;
     result = Py_BuildValue(
-        PySass_IF_PY3("hyy", "hss"),
+        PySass_IF_PY3("hyyN", "hssN"),
         (short int) !context->error_status,
         error_status ? context->error_message : context->output_string,
         error_status || context->source_map_string == NULL
             ? ""
-            : context->source_map_string
+            : context->source_map_string,
+        PySass_make_import_graph(context->import_graph,
+                                 context->num_import_graph_entries)
     );
     sass_free_file_context(context);
     return result;
@@ -154,6 +306,303 @@ PySass_compile_dirname(PyObject *self, PyObject *args) {
     return result;
 }
 
+/* A batch of compile jobs shared by the worker threads of
+   PySass_compile_many().  Each worker takes the next unclaimed job
+   until there are no more, so a few slow inputs don't stall the rest. */
+struct PySass_Batch {
+    int is_file;
+    void **contexts;
+    long size;
+    PySass_Counter next;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+PySass_batch_worker(void *arg) {
+    struct PySass_Batch *batch = (struct PySass_Batch *) arg;
+    long i;
+    while ((i = PySass_Atomic_Next(&batch->next)) < batch->size) {
+        if (batch->is_file) {
+            sass_compile_file((struct sass_file_context *) batch->contexts[i]);
+        } else {
+            sass_compile((struct sass_context *) batch->contexts[i]);
+        }
+    }
+    return 0;
+}
+
+static void
+PySass_run_batch(struct PySass_Batch *batch, int workers) {
+    int i, started = 0;
+#ifdef _WIN32
+    HANDLE *threads = malloc(sizeof(HANDLE) * workers);
+    for (i = 1; threads != NULL && i < workers; ++i) {
+        threads[started] = CreateThread(NULL, 0, PySass_batch_worker,
+                                        batch, 0, NULL);
+        if (threads[started] != NULL) ++started;
+    }
+#else
+    pthread_t *threads = malloc(sizeof(pthread_t) * workers);
+    for (i = 1; threads != NULL && i < workers; ++i) {
+        if (!pthread_create(&threads[started], NULL,
+                            PySass_batch_worker, batch)) {
+            ++started;
+        }
+    }
+#endif
+    /* The calling thread works too; if no thread could be started
+       (or there's no memory for them) it simply compiles the whole
+       batch by itself. */
+    PySass_batch_worker(batch);
+    for (i = 0; i < started; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+    free(threads);
+}
+
+static PyObject *
+PySass_compile_many(PyObject *self, PyObject *args) {
+    struct PySass_Batch batch;
+    struct sass_context *string_context = NULL;
+    struct sass_file_context *file_context = NULL;
+    char *include_paths, *image_path, *output, *source_map;
+    int is_file, output_style, source_comments, workers, error_status;
+    struct sass_import_graph_entry *graph;
+    int graph_size;
+    PyObject *inputs, *source_map_filenames, *item, *result, *compiled;
+    long i, size;
+
+    if (!PyArg_ParseTuple(args,
+                          PySass_IF_PY3("iOiiyyOi", "iOiissOi"),
+                          &is_file, &inputs, &output_style, &source_comments,
+                          &include_paths, &image_path,
+                          &source_map_filenames, &workers)) {
+        return NULL;
+    }
+    /* Own a private tuple of the inputs so that nothing can release
+       them while the GIL is released. */
+    inputs = PySequence_Tuple(inputs);
+    if (inputs == NULL) {
+        return NULL;
+    }
+    source_map_filenames = PySequence_Tuple(source_map_filenames);
+    if (source_map_filenames == NULL) {
+        Py_DECREF(inputs);
+        return NULL;
+    }
+    size = (long) PyTuple_GET_SIZE(inputs);
+    for (i = 0; i < size; ++i) {
+        if (!PySass_Bytes_Check(PyTuple_GET_ITEM(inputs, i))) {
+            PyErr_SetString(PyExc_TypeError, "inputs must be bytes");
+            Py_DECREF(inputs);
+            Py_DECREF(source_map_filenames);
+            return NULL;
+        }
+    }
+
+    batch.is_file = is_file;
+    batch.contexts = calloc((size_t) size + 1, sizeof(void *));
+    if (batch.contexts == NULL) {
+        Py_DECREF(inputs);
+        Py_DECREF(source_map_filenames);
+        return PyErr_NoMemory();
+    }
+    batch.size = size;
+    batch.next = 0;
+    for (i = 0; i < size; ++i) {
+        item = PyTuple_GET_ITEM(inputs, i);
+        if (is_file) {
+            file_context = sass_new_file_context();
+            file_context->input_path = PySass_Bytes_AS_STRING(item);
+            if (source_comments == SASS_SOURCE_COMMENTS_MAP &&
+                i < PyTuple_GET_SIZE(source_map_filenames) &&
+                PySass_Bytes_Check(PyTuple_GET_ITEM(source_map_filenames, i))) {
+                file_context->source_map_file = PySass_Bytes_AS_STRING(
+                    PyTuple_GET_ITEM(source_map_filenames, i)
+                );
+            }
+            file_context->options.output_style = output_style;
+            file_context->options.source_comments = source_comments;
+            file_context->options.include_paths = include_paths;
+            file_context->options.image_path = image_path;
+            batch.contexts[i] = file_context;
+        } else {
+            string_context = sass_new_context();
+            string_context->source_string = PySass_Bytes_AS_STRING(item);
+            string_context->options.output_style = output_style;
+            string_context->options.source_comments = source_comments;
+            string_context->options.include_paths = include_paths;
+            string_context->options.image_path = image_path;
+            batch.contexts[i] = string_context;
+        }
+    }
+
+    if (workers > size) {
+        workers = (int) size;
+    }
+    if (workers < 1) {
+        workers = 1;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    PySass_run_batch(&batch, workers);
+    Py_END_ALLOW_THREADS
+
+    result = PyList_New(size);
+    for (i = 0; i < size; ++i) {
+        if (is_file) {
+            file_context = (struct sass_file_context *) batch.contexts[i];
+            error_status = file_context->error_status;
+            output = error_status ? file_context->error_message
+                                  : file_context->output_string;
+            source_map = file_context->source_map_string;
+            graph = file_context->import_graph;
+            graph_size = file_context->num_import_graph_entries;
+        } else {
+            string_context = (struct sass_context *) batch.contexts[i];
+            error_status = string_context->error_status;
+            output = error_status ? string_context->error_message
+                                  : string_context->output_string;
+            source_map = string_context->source_map_string;
+            graph = string_context->import_graph;
+            graph_size = string_context->num_import_graph_entries;
+        }
+        compiled = Py_BuildValue(
+            PySass_IF_PY3("hyyN", "hssN"),
+            (short int) !error_status,
+            output,
+            error_status || source_map == NULL ? "" : source_map,
+            PySass_make_import_graph(graph, graph_size)
+        );
+        if (result != NULL && compiled != NULL) {
+            PyList_SET_ITEM(result, i, compiled);
+        } else {
+            Py_XDECREF(compiled);
+            Py_CLEAR(result);
+        }
+        if (is_file) {
+            sass_free_file_context(file_context);
+        } else {
+            sass_free_context(string_context);
+        }
+    }
+    free(batch.contexts);
+    Py_DECREF(inputs);
+    Py_DECREF(source_map_filenames);
+    return result;
+}
+
+#ifdef __linux__
+
+/* inotify_watch(dirnames) starts watching the given directories and returns
+   a pair of the inotify file descriptor and the list of watch descriptors.
+   Directories rather than files are watched so that editors which save
+   by renaming a new file over the old one are caught as well. */
+static PyObject *
+PySass_inotify_watch(PyObject *self, PyObject *args) {
+    PyObject *dirnames, *wds, *dirname;
+    Py_ssize_t i, size;
+    int fd, wd;
+
+    if (!PyArg_ParseTuple(args, "O", &dirnames)) {
+        return NULL;
+    }
+    dirnames = PySequence_Fast(dirnames, "dirnames must be a sequence");
+    if (dirnames == NULL) {
+        return NULL;
+    }
+    fd = inotify_init();
+    if (fd < 0) {
+        Py_DECREF(dirnames);
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    size = PySequence_Fast_GET_SIZE(dirnames);
+    wds = PyList_New(size);
+    for (i = 0; wds != NULL && i < size; ++i) {
+        dirname = PySequence_Fast_GET_ITEM(dirnames, i);
+        if (!PySass_Bytes_Check(dirname)) {
+            PyErr_SetString(PyExc_TypeError, "dirnames must be bytes");
+            Py_CLEAR(wds);
+            break;
+        }
+        wd = inotify_add_watch(fd, PySass_Bytes_AS_STRING(dirname),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE |
+                               IN_DELETE | IN_ATTRIB);
+        if (wd < 0) {
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError,
+                                           PySass_Bytes_AS_STRING(dirname));
+            Py_CLEAR(wds);
+            break;
+        }
+        PyList_SET_ITEM(wds, i, PySass_Int_FromLong((long) wd));
+    }
+    Py_DECREF(dirnames);
+    if (wds == NULL) {
+        close(fd);
+        return NULL;
+    }
+    return Py_BuildValue("iN", fd, wds);
+}
+
+/* inotify_read(fd, timeout) waits at most timeout milliseconds for
+   events and returns a list of (watch descriptor, filename) pairs. */
+static PyObject *
+PySass_inotify_read(PyObject *self, PyObject *args) {
+    char buffer[4096]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *event;
+    struct pollfd pollfd;
+    PyObject *result, *item;
+    ssize_t length = 0;
+    int fd, timeout, ready;
+    char *p;
+
+    if (!PyArg_ParseTuple(args, "ii", &fd, &timeout)) {
+        return NULL;
+    }
+    pollfd.fd = fd;
+    pollfd.events = POLLIN;
+    pollfd.revents = 0;
+    Py_BEGIN_ALLOW_THREADS
+    ready = poll(&pollfd, 1, timeout);
+    if (ready > 0) {
+        length = read(fd, buffer, sizeof(buffer));
+    }
+    Py_END_ALLOW_THREADS
+    if (ready < 0 || length < 0) {
+        if (errno != EINTR) {
+            return PyErr_SetFromErrno(PyExc_OSError);
+        } else if (PyErr_CheckSignals()) {
+            return NULL;
+        }
+        length = 0;
+    }
+    result = PyList_New(0);
+    for (p = buffer; result != NULL && p < buffer + length;
+         p += sizeof(struct inotify_event) + event->len) {
+        event = (const struct inotify_event *) p;
+        if (!event->len) {
+            continue;
+        }
+        item = Py_BuildValue(PySass_IF_PY3("iy", "is"),
+                             event->wd, event->name);
+        if (item == NULL || PyList_Append(result, item)) {
+            Py_CLEAR(result);
+        }
+        Py_XDECREF(item);
+    }
+    return result;
+}
+
+#endif
+
 static PyMethodDef PySass_methods[] = {
     {"compile_string", PySass_compile_string, METH_VARARGS,
      "Compile a SASS string."},
@@ -161,6 +610,14 @@ static PyMethodDef PySass_methods[] = {
      "Compile a SASS file."},
     {"compile_dirname", PySass_compile_dirname, METH_VARARGS,
      "Compile several SASS files."},
+    {"compile_many", PySass_compile_many, METH_VARARGS,
+     "Compile many SASS strings or files at a time in parallel."},
+#ifdef __linux__
+    {"inotify_watch", PySass_inotify_watch, METH_VARARGS,
+     "Start watching directories with inotify."},
+    {"inotify_read", PySass_inotify_read, METH_VARARGS,
+     "Wait for inotify events."},
+#endif
     {NULL, NULL, 0, NULL}
 };
 
@@ -179,6 +636,11 @@ void PySass_make_enum_dict(PyObject *enum_dict, struct PySass_Pair *pairs) {
 
 void PySass_init_module(PyObject *module) {
     PyObject *output_styles, *source_comments;
+    if (PyType_Ready(&PySass_SourceCacheType) == 0) {
+        Py_INCREF(&PySass_SourceCacheType);
+        PyModule_AddObject(module, "SourceCache",
+                           (PyObject *) &PySass_SourceCacheType);
+    }
     output_styles = PyDict_New();
     PySass_make_enum_dict(output_styles, PySass_output_style_enum);
     PyModule_AddObject(module, "OUTPUT_STYLES", output_styles);
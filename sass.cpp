@@ -55,6 +55,7 @@ extern "C" {
                          .include_paths_array (/*c_ctx->include_paths_array*/0)
                          .include_paths       (vector<string>())
                          .precision           (c_ctx->precision ? c_ctx->precision : 5)
+                         .source_cache        (0)
         );
         if (src_option == FILE_SOURCE) cpp_ctx.compile_file();
         else                           cpp_ctx.compile_string();
@@ -63,7 +64,7 @@ extern "C" {
       }
       catch (Error& e) {
         stringstream msg_stream;
-        msg_stream << e.path << ":" << e.position.line << ": error: " << e.message << endl;
+        msg_stream << e.path << ":" << e.position.line() << ": error: " << e.message << endl;
         string msg(msg_stream.str());
         char* msg_str = (char*) malloc(msg.size() + 1);
         strcpy(msg_str, msg.c_str());
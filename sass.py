@@ -11,17 +11,20 @@ type.
 
 """
 import collections
+import multiprocessing
 import os
 import os.path
 import sys
 
 from six import string_types, text_type
 
-from _sass import (OUTPUT_STYLES, SOURCE_COMMENTS, compile_dirname,
-                   compile_filename, compile_string)
+from _sass import (OUTPUT_STYLES, SOURCE_COMMENTS, SourceCache,
+                   compile_dirname, compile_filename,
+                   compile_many as _compile_many, compile_string)
 
 __all__ = ('MODES', 'OUTPUT_STYLES', 'SOURCE_COMMENTS', 'CompileError',
-           'and_join', 'compile')
+           'ImportGraphEntry', 'SourceCache', 'and_join', 'compile',
+           'compile_many')
 __version__ = '0.5.0'
 
 
@@ -38,6 +41,27 @@ SOURCE_COMMENTS = SOURCE_COMMENTS
 #: (:class:`collections.Set`) The set of keywords :func:`compile()` can take.
 MODES = set(['string', 'filename', 'dirname'])
 
+#: (:class:`type`) A file of the import graph that :func:`compile()` returns
+#: when ``return_graph=True``.  It's a named tuple of ``path`` (the resolved
+#: path of the file; :const:`None` for the ``string`` itself), ``hash``
+#: (a hex digest of the file contents), and ``imports`` (a tuple of
+#: the resolved paths of the files it ``@import``\ s, in order).
+#:
+#: .. versionadded:: 0.5.1
+ImportGraphEntry = collections.namedtuple('ImportGraphEntry',
+                                          'path hash imports')
+
+#: (:class:`type`) The files loaded by compiles, kept across them.  Pass
+#: the same instance to every :func:`compile()` of a file as
+#: ``source_cache``, and only the files which have changed since (by their
+#: modification times and sizes) are read and converted again.  Its
+#: ``forget(path)`` method drops a file, e.g. when it's known to have
+#: changed although its modification time and size stay the same.  An
+#: instance mustn't be shared by threads.
+#:
+#: .. versionadded:: 0.5.1
+SourceCache = SourceCache
+
 
 class CompileError(ValueError):
     """The exception type that is raised by :func:`compile()`.
@@ -113,6 +137,23 @@ def compile(**kwargs):
     :raises exceptions.IOError: when the ``filename`` doesn't exist or
                                 cannot be read
 
+    Both ``string`` and ``filename`` modes can take ``return_graph``
+    as well.  If it's :const:`True` the import graph of the compile,
+    a list of :class:`ImportGraphEntry` of which the first is the entry
+    point, is appended to the result, e.g.  a pair of ``(css, graph)``,
+    or a triple of ``(css, source_map, graph)`` if ``source_comments``
+    is ``'map'``.
+
+    :param return_graph: whether to return the import graph as well.
+                         :const:`False` by default
+    :type return_graph: :class:`bool`
+
+    The ``filename`` mode can take ``source_cache`` as well.
+
+    :param source_cache: an optional cache of the files loaded, kept
+                         across compiles
+    :type source_cache: :class:`SourceCache`
+
     The ``dirname`` is useful for automation.  It takes a pair of paths.
     The first of the ``dirname`` pair refers the source directory, contains
     several SASS source files to compiled.  SASS source files can be nested
@@ -145,6 +186,9 @@ def compile(**kwargs):
     .. versionadded:: 0.4.0
        Added ``source_comments`` and ``source_map_filename`` parameters.
 
+    .. versionadded:: 0.5.1
+       Added ``return_graph`` and ``source_cache`` parameters.
+
     """
     modes = set()
     for mode_name in MODES:
@@ -155,30 +199,18 @@ def compile(**kwargs):
     elif len(modes) > 1:
         raise TypeError(and_join(modes) + ' are exclusive each other; '
                         'cannot be used at a time')
-    output_style = kwargs.pop('output_style', 'nested')
-    if not isinstance(output_style, string_types):
-        raise TypeError('output_style must be a string, not ' +
-                        repr(output_style))
-    try:
-        output_style = OUTPUT_STYLES[output_style]
-    except KeyError:
-        raise CompileError('{0} is unsupported output_style; choose one of {1}'
-                           ''.format(output_style, and_join(OUTPUT_STYLES)))
-    source_comments = kwargs.pop('source_comments', 'none')
-    if not isinstance(source_comments, string_types):
-        raise TypeError('source_comments must be a string, not ' +
-                        repr(source_comments))
-    if 'filename' not in modes and source_comments == 'map':
-        raise CompileError('source_comments="map" is only available with '
-                           'filename= keyword argument since it has to be '
-                           'aware of it')
-    try:
-        source_comments = SOURCE_COMMENTS[source_comments]
-    except KeyError:
-        raise CompileError(
-            '{0} is unsupported source_comments; choose one of '
-            '{1}'.format(source_comments, and_join(SOURCE_COMMENTS))
-        )
+    output_style, source_comments, include_paths, image_path = \
+        _normalize_options(kwargs, modes)
+    return_graph = kwargs.pop('return_graph', False)
+    if return_graph and 'dirname' in modes:
+        raise TypeError('return_graph is unavailable for dirname')
+    source_cache = kwargs.pop('source_cache', None)
+    if source_cache is not None:
+        if 'filename' not in modes:
+            raise TypeError('source_cache is available only for filename')
+        elif not isinstance(source_cache, SourceCache):
+            raise TypeError('source_cache must be a sass.SourceCache, not ' +
+                            repr(source_cache))
     fs_encoding = sys.getfilesystemencoding() or sys.getdefaultencoding()
     try:
         source_map_filename = kwargs.pop('source_map_filename') or b''
@@ -196,38 +228,18 @@ def compile(**kwargs):
                             repr(source_map_filename))
         if isinstance(source_map_filename, text_type):
             source_map_filename = source_map_filename.encode(fs_encoding)
-    try:
-        include_paths = kwargs.pop('include_paths') or b''
-    except KeyError:
-        include_paths = b''
-    else:
-        if isinstance(include_paths, collections.Sequence):
-            include_paths = os.pathsep.join(include_paths)
-        elif not isinstance(include_paths, string_types):
-            raise TypeError('include_paths must be a sequence of strings, or '
-                            'a colon-separated (or semicolon-separated if '
-                            'Windows) string, not ' + repr(include_paths))
-        if isinstance(include_paths, text_type):
-            include_paths = include_paths.encode(fs_encoding)
-    try:
-        image_path = kwargs.pop('image_path')
-    except KeyError:
-        image_path = b'.'
-    else:
-        if not isinstance(image_path, string_types):
-            raise TypeError('image_path must be a string, not ' +
-                            repr(image_path))
-        elif isinstance(image_path, text_type):
-            image_path = image_path.encode(fs_encoding)
     if 'string' in modes:
         string = kwargs.pop('string')
         if isinstance(string, text_type):
             string = string.encode('utf-8')
-        s, v = compile_string(string,
-                              output_style, source_comments,
-                              include_paths, image_path)
+        s, v, graph = compile_string(string,
+                                     output_style, source_comments,
+                                     include_paths, image_path)
         if s:
-            return v.decode('utf-8')
+            v = v.decode('utf-8')
+            if return_graph:
+                v = v, _make_import_graph(graph)
+            return v
     elif 'filename' in modes:
         filename = kwargs.pop('filename')
         if not isinstance(filename, string_types):
@@ -236,15 +248,19 @@ def compile(**kwargs):
             raise IOError('{0!r} seems not a file'.format(filename))
         elif isinstance(filename, text_type):
             filename = filename.encode(fs_encoding)
-        s, v, source_map = compile_filename(
+        s, v, source_map, graph = compile_filename(
             filename,
             output_style, source_comments,
-            include_paths, image_path, source_map_filename
+            include_paths, image_path, source_map_filename,
+            source_cache
         )
         if s:
             v = v.decode('utf-8')
             if source_map_filename:
                 v = v, source_map.decode('utf-8')
+            if return_graph:
+                v = (v if source_map_filename else (v,)) + \
+                    (_make_import_graph(graph),)
             return v
     elif 'dirname' in modes:
         try:
@@ -268,6 +284,219 @@ def compile(**kwargs):
     raise CompileError(v)
 
 
+def compile_many(**kwargs):
+    """Compiles many SASS sources at a time.  It takes a sequence of
+    either ``string`` or ``filename``, and compiles them in parallel
+    native threads without holding the GIL.  All of them share the same
+    options.
+
+    >>> css_list = sass.compile_many(filename=['a.scss', 'b.scss'],
+    ...                              workers=4)
+
+    :param string: a sequence of SASS source codes to compile.
+                   it's exclusive to ``filename``
+    :type string: :class:`collections.Sequence`
+    :param filename: a sequence of filenames of SASS source codes
+                     to compile.  it's exclusive to ``string``
+    :type filename: :class:`collections.Sequence`
+    :param workers: an optional number of threads to use.
+                    the number of CPUs by default
+    :type workers: :class:`int`
+    :param output_style: an optional coding style of the compiled results.
+                         choose one of: ``'nested'`` (default), ``'expanded'``,
+                         ``'compact'``, ``'compressed'``
+    :type output_style: :class:`str`
+    :param source_comments: an optional source comments mode of the compiled
+                            results.  choose one of ``'none'`` (default),
+                            ``'line_numbers'``, ``'map'``.
+                            ``'map'`` is available only for ``filename``
+                            and requires ``source_map_filenames`` as well
+    :type source_comments: :class:`str`
+    :param source_map_filenames: a sequence of the source map output
+                                 filenames, one for each ``filename``.
+                                 it's only available and required when
+                                 ``source_comments`` is ``'map'``
+    :type source_map_filenames: :class:`collections.Sequence`
+    :param include_paths: an optional list of paths to find ``@import``\ ed
+                          SASS/CSS source files
+    :type include_paths: :class:`collections.Sequence`, :class:`str`
+    :param image_path: an optional path to find images
+    :type image_path: :class:`str`
+    :param return_graph: whether to append the import graph to each
+                         result as :func:`compile()` does.
+                         :const:`False` by default
+    :type return_graph: :class:`bool`
+    :returns: a list of results in the same order as the inputs.
+              each result is the compiled CSS string, or a pair of
+              the compiled CSS string and the source map string if
+              ``source_comments='map'``.  failed inputs don't raise
+              but have an exception instance instead:
+              :exc:`CompileError`, or :exc:`exceptions.IOError` if
+              the ``filename`` doesn't exist
+    :rtype: :class:`list`
+
+    .. versionadded:: 0.5.1
+
+    """
+    modes = set(mode for mode in ('string', 'filename') if mode in kwargs)
+    if not modes:
+        raise TypeError('choose one at least in string and filename')
+    elif len(modes) > 1:
+        raise TypeError('string and filename are exclusive each other; '
+                        'cannot be used at a time')
+    elif 'dirname' in kwargs:
+        raise TypeError('dirname is unavailable for compile_many()')
+    workers = kwargs.pop('workers', None)
+    if workers is None:
+        try:
+            workers = multiprocessing.cpu_count()
+        except NotImplementedError:
+            workers = 1
+    elif not isinstance(workers, int) or workers < 1:
+        raise TypeError('workers must be a positive integer, not ' +
+                        repr(workers))
+    output_style, source_comments, include_paths, image_path = \
+        _normalize_options(kwargs, modes)
+    return_graph = kwargs.pop('return_graph', False)
+    fs_encoding = sys.getfilesystemencoding() or sys.getdefaultencoding()
+    source_map_filenames = kwargs.pop('source_map_filenames', None)
+    map_mode = source_comments == SOURCE_COMMENTS['map']
+    if map_mode and source_map_filenames is None:
+        raise TypeError('source_comments="map" requires '
+                        'source_map_filenames argument')
+    elif not map_mode and source_map_filenames is not None:
+        raise TypeError('source_map_filenames is available only with '
+                        'source_comments="map"')
+    results = []
+    inputs = []
+    map_filenames = []
+    if 'string' in modes:
+        for string in kwargs.pop('string'):
+            if isinstance(string, text_type):
+                string = string.encode('utf-8')
+            elif not isinstance(string, bytes):
+                raise TypeError('string must be a string, not ' +
+                                repr(string))
+            results.append(None)
+            inputs.append(string)
+    else:
+        filenames = list(kwargs.pop('filename'))
+        if map_mode:
+            source_map_filenames = list(source_map_filenames)
+            if len(source_map_filenames) != len(filenames):
+                raise ValueError('source_map_filenames must have the same '
+                                 'length as filename')
+        for i, filename in enumerate(filenames):
+            if not isinstance(filename, string_types):
+                raise TypeError('filename must be a string, not ' +
+                                repr(filename))
+            elif not os.path.isfile(filename):
+                results.append(
+                    IOError('{0!r} seems not a file'.format(filename))
+                )
+                continue
+            elif isinstance(filename, text_type):
+                filename = filename.encode(fs_encoding)
+            results.append(None)
+            inputs.append(filename)
+            if map_mode:
+                map_filename = source_map_filenames[i]
+                if isinstance(map_filename, text_type):
+                    map_filename = map_filename.encode(fs_encoding)
+                map_filenames.append(map_filename)
+    compiled = iter(_compile_many('filename' in modes, inputs,
+                                  output_style, source_comments,
+                                  include_paths, image_path,
+                                  map_filenames, workers))
+    for i, result in enumerate(results):
+        if result is not None:
+            continue
+        s, v, source_map, graph = next(compiled)
+        if not s:
+            results[i] = CompileError(v)
+            continue
+        v = v.decode('utf-8')
+        if map_mode:
+            v = v, source_map.decode('utf-8')
+        if return_graph:
+            v = (v if map_mode else (v,)) + (_make_import_graph(graph),)
+        results[i] = v
+    return results
+
+
+def _make_import_graph(graph):
+    """Turns the import graph :mod:`_sass` returns, a list of
+    ``(path, hash, import_indices)`` triples, into a list of
+    :class:`ImportGraphEntry`.
+
+    """
+    fs_encoding = sys.getfilesystemencoding() or sys.getdefaultencoding()
+    paths = [path.decode(fs_encoding) or None for path, _, _ in graph]
+    return [
+        ImportGraphEntry(paths[i], hash_.decode('ascii'),
+                         tuple(paths[j] for j in imports))
+        for i, (_, hash_, imports) in enumerate(graph)
+    ]
+
+
+def _normalize_options(kwargs, modes):
+    """Pops and validates the options shared by :func:`compile()` and
+    :func:`compile_many()` from ``kwargs``, and returns a tuple of
+    ``(output_style, source_comments, include_paths, image_path)`` that
+    the :mod:`_sass` functions take.
+
+    """
+    output_style = kwargs.pop('output_style', 'nested')
+    if not isinstance(output_style, string_types):
+        raise TypeError('output_style must be a string, not ' +
+                        repr(output_style))
+    try:
+        output_style = OUTPUT_STYLES[output_style]
+    except KeyError:
+        raise CompileError('{0} is unsupported output_style; choose one of {1}'
+                           ''.format(output_style, and_join(OUTPUT_STYLES)))
+    source_comments = kwargs.pop('source_comments', 'none')
+    if not isinstance(source_comments, string_types):
+        raise TypeError('source_comments must be a string, not ' +
+                        repr(source_comments))
+    if 'filename' not in modes and source_comments == 'map':
+        raise CompileError('source_comments="map" is only available with '
+                           'filename= keyword argument since it has to be '
+                           'aware of it')
+    try:
+        source_comments = SOURCE_COMMENTS[source_comments]
+    except KeyError:
+        raise CompileError(
+            '{0} is unsupported source_comments; choose one of '
+            '{1}'.format(source_comments, and_join(SOURCE_COMMENTS))
+        )
+    fs_encoding = sys.getfilesystemencoding() or sys.getdefaultencoding()
+    try:
+        include_paths = kwargs.pop('include_paths') or b''
+    except KeyError:
+        include_paths = b''
+    else:
+        if isinstance(include_paths, collections.Sequence):
+            include_paths = os.pathsep.join(include_paths)
+        elif not isinstance(include_paths, string_types):
+            raise TypeError('include_paths must be a sequence of strings, or '
+                            'a colon-separated (or semicolon-separated if '
+                            'Windows) string, not ' + repr(include_paths))
+        if isinstance(include_paths, text_type):
+            include_paths = include_paths.encode(fs_encoding)
+    try:
+        image_path = kwargs.pop('image_path')
+    except KeyError:
+        image_path = b'.'
+    else:
+        if not isinstance(image_path, string_types):
+            raise TypeError('image_path must be a string, not ' +
+                            repr(image_path))
+        elif isinstance(image_path, text_type):
+            image_path = image_path.encode(fs_encoding)
+    return output_style, source_comments, include_paths, image_path
+
+
 def and_join(strings):
     """Join the given ``strings`` by commas with last `' and '` conjuction.
 
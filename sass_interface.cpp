@@ -7,6 +7,10 @@
 #include "sass_interface.h"
 #include "context.hpp"
 
+#ifndef SASS_FILE
+#include "file.hpp"
+#endif
+
 #ifndef SASS_ERROR_HANDLING
 #include "error_handling.hpp"
 #endif
@@ -17,6 +21,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <new>
+
+struct sass_source_cache {
+  Sass::Source_Cache sources;
+};
 
 extern "C" {
   using namespace std;
@@ -35,6 +44,20 @@ extern "C" {
     free(arr);
   }
 
+  void free_import_graph(sass_import_graph_entry* graph, int num)
+  {
+    if (!graph)
+        return;
+
+    for (int i = 0; i < num; i++) {
+      free(graph[i].path);
+      free(graph[i].hash);
+      free(graph[i].imports);
+    }
+
+    free(graph);
+  }
+
   void sass_free_context(sass_context* ctx)
   {
     if (ctx->output_string) free(ctx->output_string);
@@ -42,6 +65,7 @@ extern "C" {
     if (ctx->error_message) free(ctx->error_message);
 
     free_string_array(ctx->included_files, ctx->num_included_files);
+    free_import_graph(ctx->import_graph, ctx->num_import_graph_entries);
 
     free(ctx);
   }
@@ -56,6 +80,7 @@ extern "C" {
     if (ctx->error_message)     free(ctx->error_message);
 
     free_string_array(ctx->included_files, ctx->num_included_files);
+    free_import_graph(ctx->import_graph, ctx->num_import_graph_entries);
 
     free(ctx);
   }
@@ -69,6 +94,15 @@ extern "C" {
     free(ctx);
   }
 
+  sass_source_cache* sass_new_source_cache()
+  { return new (nothrow) sass_source_cache(); }
+
+  void sass_free_source_cache(sass_source_cache* cache)
+  { delete cache; }
+
+  void sass_source_cache_forget(sass_source_cache* cache, const char* path)
+  { cache->sources.forget(path); }
+
   void copy_strings(const std::vector<std::string>& strings, char*** array, int* n) {
     int num = strings.size();
     char** arr = (char**) malloc(sizeof(char*)* num);
@@ -83,6 +117,24 @@ extern "C" {
     *n = num;
   }
 
+  void copy_import_graph(const std::vector<Sass::Included_File>& files, sass_import_graph_entry** graph, int* n) {
+    int num = files.size();
+    sass_import_graph_entry* entries = (sass_import_graph_entry*) calloc(num ? num : 1, sizeof(sass_import_graph_entry));
+
+    for (int i = 0; i < num; i++) {
+      entries[i].path = strdup(files[i].path.c_str());
+      entries[i].hash = strdup(files[i].hash.c_str());
+      entries[i].num_imports = files[i].imports.size();
+      entries[i].imports = (int*) malloc(sizeof(int) * (entries[i].num_imports + 1));
+      for (int j = 0; j < entries[i].num_imports; j++) {
+        entries[i].imports[j] = files[i].imports[j];
+      }
+    }
+
+    *graph = entries;
+    *n = num;
+  }
+
   int sass_compile(sass_context* c_ctx)
   {
     using namespace Sass;
@@ -111,6 +163,7 @@ extern "C" {
                        .include_paths_array(0)
                        .include_paths(vector<string>())
                        .precision(c_ctx->options.precision ? c_ctx->options.precision : 5)
+                       .source_cache(0)
       );
       if (c_ctx->c_functions) {
         struct Sass_C_Function_Descriptor* this_func_data = c_ctx->c_functions;
@@ -125,10 +178,11 @@ extern "C" {
       c_ctx->error_status = 0;
 
       copy_strings(cpp_ctx.get_included_files(), &c_ctx->included_files, &c_ctx->num_included_files);
+      copy_import_graph(cpp_ctx.get_import_graph(), &c_ctx->import_graph, &c_ctx->num_import_graph_entries);
     }
     catch (Error& e) {
       stringstream msg_stream;
-      msg_stream << e.path << ":" << e.position.line << ": error: " << e.message << endl;
+      msg_stream << e.path << ":" << e.position.line() << ": error: " << e.message << endl;
       c_ctx->error_message = strdup(msg_stream.str().c_str());
       c_ctx->error_status = 1;
       c_ctx->output_string = 0;
@@ -173,6 +227,7 @@ extern "C" {
                        .include_paths_array(0)
                        .include_paths(vector<string>())
                        .precision(c_ctx->options.precision ? c_ctx->options.precision : 5)
+                       .source_cache(c_ctx->source_cache ? &c_ctx->source_cache->sources : 0)
       );
       if (c_ctx->c_functions) {
         struct Sass_C_Function_Descriptor* this_func_data = c_ctx->c_functions;
@@ -187,10 +242,11 @@ extern "C" {
       c_ctx->error_status = 0;
 
       copy_strings(cpp_ctx.get_included_files(), &c_ctx->included_files, &c_ctx->num_included_files);
+      copy_import_graph(cpp_ctx.get_import_graph(), &c_ctx->import_graph, &c_ctx->num_import_graph_entries);
     }
     catch (Error& e) {
       stringstream msg_stream;
-      msg_stream << e.path << ":" << e.position.line << ": error: " << e.message << endl;
+      msg_stream << e.path << ":" << e.position.line() << ": error: " << e.message << endl;
       c_ctx->error_message = strdup(msg_stream.str().c_str());
       c_ctx->error_status = 1;
       c_ctx->output_string = 0;
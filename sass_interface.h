@@ -25,6 +25,20 @@ struct sass_options {
   int precision;
 };
 
+// a file in the import graph of a compile; the first one is the entry
+// point (with an empty path when compiling a string)
+struct sass_import_graph_entry {
+  char* path; // resolved path of the file
+  char* hash; // 64-bit FNV-1a hash of its contents, in hex
+  int* imports; // indices of the entries it @imports, in order
+  int num_imports;
+};
+
+// the files loaded by compiles, kept across the compiles of a file it's
+// given to so that only the files which have changed since are read again;
+// it mustn't be used by more than one compile at a time
+struct sass_source_cache;
+
 struct sass_context {
   const char* input_path;
   const char* output_path;
@@ -38,6 +52,8 @@ struct sass_context {
   struct Sass_C_Function_Descriptor* c_functions;
   char** included_files;
   int num_included_files;
+  struct sass_import_graph_entry* import_graph;
+  int num_import_graph_entries;
 };
 
 struct sass_file_context {
@@ -52,6 +68,9 @@ struct sass_file_context {
   struct Sass_C_Function_Descriptor* c_functions;
   char** included_files;
   int num_included_files;
+  struct sass_import_graph_entry* import_graph;
+  int num_import_graph_entries;
+  struct sass_source_cache* source_cache; // optional
 };
 
 struct sass_folder_context {
@@ -68,10 +87,16 @@ struct sass_folder_context {
 struct sass_context*        sass_new_context        (void);
 struct sass_file_context*   sass_new_file_context   (void);
 struct sass_folder_context* sass_new_folder_context (void);
+struct sass_source_cache*   sass_new_source_cache   (void);
 
 void sass_free_context        (struct sass_context* ctx);
 void sass_free_file_context   (struct sass_file_context* ctx);
 void sass_free_folder_context (struct sass_folder_context* ctx);
+void sass_free_source_cache   (struct sass_source_cache* cache);
+
+// drops the file at the path from the cache, e.g. when it's known to have
+// changed in a way its modification time and size don't tell
+void sass_source_cache_forget (struct sass_source_cache* cache, const char* path);
 
 int sass_compile            (struct sass_context* ctx);
 int sass_compile_file       (struct sass_file_context* ctx);
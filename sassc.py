@@ -35,11 +35,15 @@ There are options as well:
 
 .. option:: -w, --watch
 
-   Watch file for changes.  Requires the second argument (output CSS
-   filename).
+   Watch file, and every file it ``@import``\ s, for changes.  Requires
+   the second argument (output CSS filename).  On Linux it's notified of
+   changes by inotify, and on other platforms it polls the files.
 
    .. versionadded:: 0.4.0
 
+   .. versionchanged:: 0.5.1
+      Watches also imported files, and uses inotify on Linux.
+
 .. option:: -v, --version
 
    Prints the program version.
@@ -56,10 +60,17 @@ from __future__ import print_function
 import functools
 import optparse
 import os
+import os.path
 import sys
 import time
 
-from sass import __version__ as VERSION, OUTPUT_STYLES, CompileError, compile
+from sass import (__version__ as VERSION, OUTPUT_STYLES, CompileError,
+                  SourceCache, compile)
+
+try:
+    from _sass import inotify_read, inotify_watch
+except ImportError:
+    inotify_read = inotify_watch = None
 
 
 def main(argv=sys.argv, stdout=sys.stdout, stderr=sys.stderr):
@@ -84,8 +95,9 @@ def main(argv=sys.argv, stdout=sys.stdout, stderr=sys.stderr):
     parser.add_option('-i', '--image-path', metavar='DIR', default='./',
                       help='Path to find images. [default: %default]')
     parser.add_option('-w', '--watch', action='store_true',
-                      help='Watch file for changes.  Requires the second '
-                           'argument (output css filename).')
+                      help='Watch file and files it imports for changes.  '
+                           'Requires the second argument (output css '
+                           'filename).')
     options, args = parser.parse_args(argv[1:])
     error = functools.partial(print,
                               parser.get_prog_name() + ': error:',
@@ -111,28 +123,36 @@ def main(argv=sys.argv, stdout=sys.stdout, stderr=sys.stderr):
         return 2
     else:
         pass
+    filenames = [os.path.abspath(filename)]
+    # recompiles read only the files which have changed since
+    source_cache = SourceCache() if options.watch else None
+    fs_encoding = sys.getfilesystemencoding() or sys.getdefaultencoding()
     while True:
         try:
             if options.source_map:
                 source_map_filename = args[1] + '.map'  # FIXME
-                css, source_map = compile(
+                css, source_map, graph = compile(
                     filename=filename,
                     output_style=options.output_style,
                     source_comments='map',
                     source_map_filename=source_map_filename,
                     include_paths=options.include_paths,
-                    image_path=options.image_path
+                    image_path=options.image_path,
+                    return_graph=True,
+                    source_cache=source_cache
                 )
             else:
                 source_map_filename = None
                 source_map = None
-                css = compile(
+                css, graph = compile(
                     filename=filename,
                     output_style=options.output_style,
                     include_paths=options.include_paths,
-                    image_path=options.image_path
+                    image_path=options.image_path,
+                    return_graph=True,
+                    source_cache=source_cache
                 )
-            mtime = os.stat(filename).st_mtime
+            filenames = [entry.path for entry in graph]
         except (IOError, OSError) as e:
             error(e)
             return 3
@@ -158,20 +178,64 @@ def main(argv=sys.argv, stdout=sys.stdout, stderr=sys.stderr):
                 with open(source_map_filename, 'w') as f:
                     f.write(source_map)
         if options.watch:  # pragma: no cover
-            # FIXME: we should utilize inotify on Linux, and FSEvents on Mac
-            while True:
-                try:
-                    st = os.stat(filename)
-                    if st.st_mtime > mtime:
-                        print(filename, 'changed; recompile...', file=stdout)
-                        break
-                    time.sleep(0.5)
-                except KeyboardInterrupt:
-                    return 0
+            try:
+                changed = wait_for_changes(filenames)
+            except KeyboardInterrupt:
+                return 0
+            print(changed, 'changed; recompile...', file=stdout)
+            # it may have changed within the resolution of its mtime
+            source_cache.forget(
+                changed.encode(fs_encoding)
+                if not isinstance(changed, bytes) else changed
+            )
         else:
             break
     return 0
 
 
+def get_mtime(filename):
+    try:
+        return os.stat(filename).st_mtime
+    except (IOError, OSError):
+        return None
+
+
+def wait_for_changes(filenames):  # pragma: no cover
+    """Blocks until any of the given ``filenames`` is modified,
+    and then returns its filename.  It's notified of changes by inotify
+    on Linux, and polls the files every 0.5 seconds on other platforms.
+
+    """
+    mtimes = dict((f, get_mtime(f)) for f in filenames)
+    fd = None
+    if inotify_watch is not None:
+        fs_encoding = sys.getfilesystemencoding() or sys.getdefaultencoding()
+        dirnames = list(set(os.path.dirname(f) for f in filenames))
+        fd, wds = inotify_watch([
+            d.encode(fs_encoding) if not isinstance(d, bytes) else d
+            for d in dirnames
+        ])
+        watched = dict(zip(wds, dirnames))
+    try:
+        while True:
+            # files might have changed before they have started to be
+            # watched, so check their mtimes as well
+            for f, mtime in mtimes.items():
+                if get_mtime(f) != mtime:
+                    return f
+            if fd is None:
+                time.sleep(0.5)
+                continue
+            for wd, name in inotify_read(fd, 500):
+                if not isinstance(name, str):
+                    name = name.decode(fs_encoding)
+                f = os.path.join(watched[wd], name)
+                if f in mtimes:
+                    return f
+    finally:
+        if fd is not None:
+            os.close(fd)
+
+
 if __name__ == '__main__':
     sys.exit(main())
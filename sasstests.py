@@ -7,6 +7,7 @@ import os
 import os.path
 import re
 import shutil
+import sys
 import tempfile
 import unittest
 
@@ -16,7 +17,9 @@ from werkzeug.wrappers import Response
 
 import sass
 import sassc
-from sassutils.builder import Manifest, build_directory
+import sassutils.builder
+import sassutils.wsgi
+from sassutils.builder import STATE_FILENAME, Manifest, build_directory
 from sassutils.wsgi import SassMiddleware
 
 
@@ -169,6 +172,19 @@ a {
                           string='a { b { color: blue; }',
                           source_comments='map')
 
+    def test_compile_error_lines(self):
+        for source, line in [('a {\n  b: 1px +\n 1em;\n}\n', 2),
+                             ('a {\n  b: #{\n\n1px + 1em\n\n};\n}\n', 4),
+                             ('a {\n  b: foo(\n    #{1px +\n\n 1em});\n}\n',
+                              3),
+                             ('\n\n/* x\ny */ .a { b: c', 4)]:
+            try:
+                sass.compile(string=source)
+            except sass.CompileError as e:
+                assert 'source string:%d:' % line in str(e), str(e)
+            else:
+                self.fail('expected sass.CompileError')
+
     def test_compile_filename(self):
         actual = sass.compile(filename='test/a.scss')
         assert actual == A_EXPECTED_CSS
@@ -196,6 +212,129 @@ a {
             json.loads(source_map)
         )
 
+    def test_compile_source_map_comparisons(self):
+        temp_path = tempfile.mkdtemp()
+        try:
+            filename = os.path.join(temp_path, 'comparisons.scss')
+            with open(filename, 'w') as f:
+                f.write('$t: 1 < 2;\na {\n  b: $t;\n  c: 1 == 1; }\n')
+            actual, source_map = sass.compile(
+                filename=filename,
+                source_comments='map',
+                source_map_filename='comparisons.scss.css.map'
+            )
+            # a stored comparison maps to itself, not to its declaration
+            self.assertEqual('AACA;EACE,GAFE;EAGF,GAAG',
+                             json.loads(source_map)['mappings'])
+        finally:
+            shutil.rmtree(temp_path)
+
+    def test_compile_return_graph(self):
+        css, graph = sass.compile(filename='test/c.scss', return_graph=True)
+        self.assertEqual(C_EXPECTED_CSS, css)
+        self.assertEqual(2, len(graph))
+        c, a = graph
+        self.assertEqual(os.path.abspath('test/c.scss'), c.path)
+        self.assertEqual((a.path,), c.imports)
+        self.assertEqual(os.path.abspath('test/a.scss'), a.path)
+        self.assertEqual((), a.imports)
+        assert re.match(r'^[0-9a-f]{16}$', a.hash)
+        self.assertNotEqual(a.hash, c.hash)
+        css, source_map, graph = sass.compile(
+            filename='test/a.scss',
+            source_comments='map',
+            source_map_filename='a.scss.css.map',
+            return_graph=True
+        )
+        self.assertEqual(A_EXPECTED_CSS_WITH_MAP, css)
+        self.assertEqual([a], graph)
+        css, graph = sass.compile(string='@import "test/b";',
+                                  return_graph=True)
+        self.assertEqual(B_EXPECTED_CSS, css)
+        self.assertEqual(2, len(graph))
+        self.assertEqual(None, graph[0].path)
+        self.assertEqual((graph[1].path,), graph[0].imports)
+
+    def test_compile_return_graph_indented(self):
+        def fnv1a(data):
+            h = 14695981039346656037
+            for byte in bytearray(data):
+                h = ((h ^ byte) * 1099511628211) & 0xffffffffffffffff
+            return '%016x' % h
+        temp_path = tempfile.mkdtemp()
+        try:
+            filename = os.path.join(temp_path, 'a.sass')
+            source = b('a\n  b: c\n')
+            with open(filename, 'wb') as f:
+                f.write(source)
+            for _ in range(2):  # converted, then from the cache
+                css, graph = sass.compile(filename=filename,
+                                          output_style='compressed',
+                                          return_graph=True)
+                self.assertEqual('a{b:c;}', css.strip())
+                self.assertEqual(fnv1a(source), graph[0].hash)
+        finally:
+            shutil.rmtree(temp_path)
+
+    def test_compile_source_cache(self):
+        temp_path = tempfile.mkdtemp()
+        try:
+            a_path = os.path.join(temp_path, '_a.scss')
+            c_path = os.path.join(temp_path, 'c.scss')
+            with open(a_path, 'w') as f:
+                f.write('a { b: c; }\n')
+            with open(c_path, 'w') as f:
+                f.write('@import "a";\n')
+            cache = sass.SourceCache()
+            css = sass.compile(filename=c_path, output_style='compressed',
+                               source_cache=cache)
+            self.assertEqual('a{b:c;}', css.strip())
+            # a modified file is read again
+            with open(a_path, 'w') as f:
+                f.write('a { b: cd; }\n')
+            stat = os.stat(a_path)
+            css = sass.compile(filename=c_path, output_style='compressed',
+                               source_cache=cache)
+            self.assertEqual('a{b:cd;}', css.strip())
+            # ... but not one which has the same mtime and size, until
+            # it's forgotten
+            with open(a_path, 'w') as f:
+                f.write('a { b: ef; }\n')
+            os.utime(a_path, (stat.st_atime, stat.st_mtime))
+            css = sass.compile(filename=c_path, output_style='compressed',
+                               source_cache=cache)
+            self.assertEqual('a{b:cd;}', css.strip())
+            cache.forget(os.path.abspath(a_path).encode(
+                sys.getfilesystemencoding()
+            ))
+            css = sass.compile(filename=c_path, output_style='compressed',
+                               source_cache=cache)
+            self.assertEqual('a{b:ef;}', css.strip())
+            self.assertRaises(TypeError, sass.compile,
+                              string='a { b: c; }', source_cache=cache)
+            self.assertRaises(TypeError, sass.compile,
+                              filename=c_path, source_cache={})
+        finally:
+            shutil.rmtree(temp_path)
+
+    def test_compile_plain_selectors(self):
+        actual = sass.compile(string='''a b{c:d}
+  .x   .y >   .z ,#w, ,  k {c:d}
+div
+  .q
+  ,
+  p {x:y}
+.a { > .b.c#d { e: f } + .g, ~ h {i: j} }
+''', source_comments='line_numbers')
+        self.assertEqual(
+            '/* line 1, source string */\na b {\n  c: d; }\n\n'
+            '/* line 2, source string */\n.x .y > .z, #w, k {\n  c: d; }\n\n'
+            '/* line 6, source string */\ndiv .q, p {\n  x: y; }\n\n'
+            '/* line 7, source string */\n.a > .b.c#d {\n  e: f; }\n'
+            '/* line 7, source string */\n.a + .g, .a ~ h {\n  i: j; }\n',
+            actual
+        )
+
     def test_regression_issue_2(self):
         actual = sass.compile(string='''
             @media (min-width: 980px) {
@@ -217,6 +356,160 @@ a {
         normalized = re.sub(r'\s+', '', actual)
         assert normalized == '@media(max-width:3){body{color:black;}}'
 
+    def test_compile_constant_expressions(self):
+        actual = sass.compile(string='''
+            @mixin m { x: 10px/2 (10px/2) lighten(#000, 10%); y: -(1px); }
+            b { @include m; }
+            c { @include m; }
+            @function lighten($color, $amount) { @return $amount; }
+            d { @include m; }
+        ''')
+        normalized = re.sub(r'\s+', '', actual)
+        assert normalized == ('b{x:10px/25px#1a1a1a;y:-1px;}'
+                              'c{x:10px/25px#1a1a1a;y:-1px;}'
+                              'd{x:10px/25px10%;y:-1px;}')
+
+    def test_compile_repeated_function_calls(self):
+        actual = sass.compile(string='''
+            $base: 16px;
+            $count: 0;
+            @function rem($px) { @return $px / $base * 1rem; }
+            @function count($n) { $count: $count + $n; @return $count; }
+            a { x: rem(32px) count(1); }
+            $base: 8px;
+            b { x: rem(32px) count(1); }
+        ''')
+        normalized = re.sub(r'\s+', '', actual)
+        assert normalized == 'a{x:2rem1;}b{x:4rem2;}'
+
+    def test_compile_loop_arithmetic(self):
+        actual = sass.compile(string='''
+            $i: 0;
+            $w: 0px;
+            @while $i < 4 { $w: $w + 2px * $i; $i: $i + 1; }
+            a { w: $w; i: $i; c: 1in > 95px, 1px > 1, 3 <= 3, $i == 4; }
+            b { t: $i > 3; u: $i < 3; s: 7px % 3px, 1px - 3, 10% + 5%; }
+        ''')
+        normalized = re.sub(r'\s+', '', actual)
+        assert normalized == ('a{w:12px;i:4;c:true,true,true,true;}'
+                              'b{t:true;u:false;s:1px,-2px,15%;}')
+
+    def test_compile_shared_values(self):
+        actual = sass.compile(string='''
+            @function twice($n) { @return $n * 2; }
+            a {
+              @for $i from 1 through 2 { b#{$i}: $i, 1 + $i, -$i, twice($i); }
+              c: index(x y, y) + 1, index(x y, y), length(x y) * 2px;
+              d: not(true) (1 < 2) == true, if(index(x y, z), a, b);
+            }
+        ''')
+        normalized = re.sub(r'\s+', '', actual)
+        assert normalized == ('a{b1:1,2,-1,2;b2:2,3,-2,4;c:3,2,4px;'
+                              'd:falsetrue,b;}')
+        for source in ['a { b: ($i * 1px) + 1em; }',
+                       'a { b: (-$i * 1px) + 1em; }',
+                       '$x: $i + 0; a { b: ($x * 1px) + 1em; }',
+                       'a { @include m($i); }']:
+            try:
+                sass.compile(string='''
+                    @mixin m($n) { b: ($n * 1px) + 1em; }
+                    @for $i from 1 through 1 { ''' + source + ' }')
+            except sass.CompileError as e:
+                assert 'source string:' in str(e), str(e)
+            else:
+                self.fail('expected sass.CompileError')
+
+    def test_compile_repeated_mixin_includes(self):
+        actual = sass.compile(string='''
+            $unit: 2px;
+            $count: 0;
+            @mixin size($n) { width: $n * $unit; height: $n; }
+            @mixin count { $count: $count + 1; n: $count; }
+            a { @include size(2); @include count; }
+            b { @include size(2); @include count; font: { @include size(2); } }
+            $unit: 3px;
+            c { @include size(2); }
+        ''')
+        normalized = re.sub(r'\s+', '', actual)
+        assert normalized == ('a{width:4px;height:2;n:1;}'
+                              'b{width:4px;height:2;n:2;'
+                              'font-width:4px;font-height:2;}'
+                              'c{width:6px;height:2;}')
+
+    def test_compile_redefined_helpers(self):
+        actual = sass.compile(string='''
+            @function f($x) { @return $x * 2; }
+            @mixin m($x) { w: f($x); }
+            @for $i from 1 through 2 { .a#{$i} { @include m($i); v: f($i); } }
+            @function f($x) { @return $x * 3; }
+            .b { @include m(1); v: f(1); }
+            @mixin m($x) { w: f($x) + 1; }
+            .c { @include m(1); }
+            .d { @function f($x) { @return $x; } v: f(1); }
+            .e { v: f(1); }
+        ''')
+        normalized = re.sub(r'\s+', '', actual)
+        assert normalized == ('.a1{w:2;v:2;}.a2{w:4;v:4;}.b{w:3;v:3;}'
+                              '.c{w:4;}.d{v:1;}.e{v:3;}')
+
+    def test_compile_appended_lists(self):
+        actual = sass.compile(string='''
+            $l: ();
+            @for $i from 1 through 4 { $l: append($l, $i, comma); }
+            $m: append($l, x);
+            $n: join($l, y z);
+            $o: append($m, w);
+            a { l: $l; m: $m; n: $n; o: $o; z: zip($l, $m); }
+        ''')
+        normalized = re.sub(r'\s+', '', actual)
+        assert normalized == ('a{l:1,2,3,4;m:1,2,3,4,x;n:1,2,3,4,y,z;'
+                              'o:1,2,3,4,x,w;z:11,22,33,44;}')
+
+
+class CompileManyTestCase(unittest.TestCase):
+
+    def test_compile_many_required_arguments(self):
+        self.assertRaises(TypeError, sass.compile_many)
+        self.assertRaises(TypeError, sass.compile_many,
+                          string=['a { color: blue; }'],
+                          filename=['test/a.scss'])
+        self.assertRaises(TypeError, sass.compile_many,
+                          string=['a { color: blue; }'], workers=0)
+
+    def test_compile_many_string(self):
+        sources = ['a { b { color: blue; } }', 'a { b { color: blue; }',
+                   u'a { color: blue; } /* 유니코드 */'] * 8
+        results = sass.compile_many(string=sources, workers=4)
+        self.assertEqual(len(sources), len(results))
+        for i in range(0, len(results), 3):
+            self.assertEqual('a b {\n  color: blue; }\n', results[i])
+            assert isinstance(results[i + 1], sass.CompileError)
+            self.assertEqual(
+                sass.compile(string=sources[i + 2]),
+                results[i + 2]
+            )
+        self.assertEqual([], sass.compile_many(string=[]))
+
+    def test_compile_many_filename(self):
+        results = sass.compile_many(
+            filename=['test/a.scss', 'test/not-exist.sass', 'test/c.scss'],
+            workers=2
+        )
+        self.assertEqual(A_EXPECTED_CSS, results[0])
+        assert isinstance(results[1], IOError)
+        self.assertEqual(C_EXPECTED_CSS, results[2])
+
+    def test_compile_many_source_map(self):
+        self.assertRaises(TypeError, sass.compile_many,
+                          filename=['test/a.scss'], source_comments='map')
+        (css, source_map), = sass.compile_many(
+            filename=['test/a.scss'],
+            source_comments='map',
+            source_map_filenames=['a.scss.css.map']
+        )
+        self.assertEqual(A_EXPECTED_CSS_WITH_MAP, css)
+        self.assertEqual(A_EXPECTED_MAP, json.loads(source_map))
+
 
 class BuilderTestCase(unittest.TestCase):
 
@@ -245,6 +538,77 @@ class BuilderTestCase(unittest.TestCase):
         self.assertEqual(D_EXPECTED_CSS, css)
         shutil.rmtree(temp_path)
 
+    def test_builder_build_directory_incrementally(self):
+        temp_path = tempfile.mkdtemp()
+        try:
+            sass_path = os.path.join(temp_path, 'sass')
+            css_path = os.path.join(temp_path, 'css')
+            shutil.copytree('test', sass_path)
+            with open(os.path.join(sass_path, '_partial.scss'), 'w') as f:
+                f.write('$color: red;')
+            with open(os.path.join(sass_path, 'e.scss'), 'w') as f:
+                f.write('@import "partial"; a { color: $color; }')
+            result_files = build_directory(sass_path, css_path)
+            assert '_partial.scss' not in result_files
+            assert not os.path.exists(
+                os.path.join(css_path, '_partial.scss.css')
+            )
+            assert os.path.isfile(os.path.join(css_path, STATE_FILENAME))
+            # mark the outputs to find out which ones are rebuilt
+            for css_filename in result_files.values():
+                with open(os.path.join(css_path, css_filename), 'w') as f:
+                    f.write('/* stale */')
+
+            def rebuilt():
+                rebuilt = set()
+                for sass_filename, css_filename in result_files.items():
+                    with open(os.path.join(css_path, css_filename)) as f:
+                        if f.read() != '/* stale */':
+                            rebuilt.add(sass_filename)
+                return rebuilt
+            self.assertEqual(result_files,
+                             build_directory(sass_path, css_path))
+            self.assertEqual(set(), rebuilt())
+            with open(os.path.join(sass_path, '_partial.scss'), 'w') as f:
+                f.write('$color: blue;')
+            with open(os.path.join(sass_path, 'a.scss'), 'a') as f:
+                f.write('\n/* changed */\n')
+            build_directory(sass_path, css_path)
+            self.assertEqual(set(['a.scss', 'c.scss', 'e.scss']), rebuilt())
+            with open(os.path.join(css_path, 'e.scss.css')) as f:
+                self.assertEqual('a {\n  color: blue; }\n', f.read())
+            build_directory(sass_path, css_path, force=True)
+            self.assertEqual(set(result_files), rebuilt())
+        finally:
+            shutil.rmtree(temp_path)
+
+    def test_builder_build_directory_modified_while_compiling(self):
+        temp_path = tempfile.mkdtemp()
+        compile_many = sassutils.builder.compile_many
+        try:
+            sass_path = os.path.join(temp_path, 'sass')
+            css_path = os.path.join(temp_path, 'css')
+            os.makedirs(sass_path)
+            with open(os.path.join(sass_path, '_partial.scss'), 'w') as f:
+                f.write('$color: red;')
+            with open(os.path.join(sass_path, 'e.scss'), 'w') as f:
+                f.write('@import "partial"; a { color: $color; }')
+
+            def modifying_compile_many(*args, **kwargs):
+                results = compile_many(*args, **kwargs)
+                with open(os.path.join(sass_path, '_partial.scss'), 'w') as f:
+                    f.write('$color: blue;')
+                return results
+            sassutils.builder.compile_many = modifying_compile_many
+            build_directory(sass_path, css_path)
+            sassutils.builder.compile_many = compile_many
+            build_directory(sass_path, css_path)
+            with open(os.path.join(css_path, 'e.scss.css')) as f:
+                self.assertEqual('a {\n  color: blue; }\n', f.read())
+        finally:
+            sassutils.builder.compile_many = compile_many
+            shutil.rmtree(temp_path)
+
 
 class ManifestTestCase(unittest.TestCase):
 
@@ -342,6 +706,101 @@ class WsgiTestCase(unittest.TestCase):
         finally:
             shutil.rmtree(css_dir)
 
+    def test_wsgi_sass_middleware_cache(self):
+        temp_path = tempfile.mkdtemp()
+        try:
+            sass_path = os.path.join(temp_path, 'sass')
+            shutil.copytree('test', sass_path)
+            app = SassMiddleware(self.sample_wsgi_app, {
+                __name__: (sass_path, sass_path, '/static')
+            })
+            client = Client(app, Response)
+            r = client.get('/static/c.scss.css')
+            self.assertEqual(200, r.status_code)
+            etag = r.headers['ETag']
+            assert r.headers['Last-Modified']
+            assert not os.path.exists(os.path.join(sass_path, 'c.scss.css'))
+            r = client.get('/static/c.scss.css.map')
+            self.assertEqual(200, r.status_code)
+            self.assertEqual('application/json', r.mimetype)
+            self.assertEqual(['a.scss', 'c.scss'],
+                             sorted(json.loads(r.data.decode('utf-8'))
+                                    ['sources']))
+            r = client.get('/static/c.scss.css',
+                           headers={'If-None-Match': etag})
+            self.assertEqual(304, r.status_code)
+            self.assertEqual(b'', r.data)
+            # modifying an imported file invalidates the cache
+            a_path = os.path.join(sass_path, 'a.scss')
+            with open(a_path, 'a') as f:
+                f.write('\nh2 { color: red; }\n')
+            stat = os.stat(a_path)
+            os.utime(a_path, (stat.st_atime, stat.st_mtime + 10))
+            r = client.get('/static/c.scss.css',
+                           headers={'If-None-Match': etag})
+            self.assertEqual(200, r.status_code)
+            self.assertNotEqual(etag, r.headers['ETag'])
+            assert b'h2 {' in r.data
+        finally:
+            shutil.rmtree(temp_path)
+
+    def test_wsgi_sass_middleware_compiles_imports_once(self):
+        temp_path = tempfile.mkdtemp()
+        compile = sassutils.wsgi.compile
+        compiled = []
+        try:
+            sass_path = os.path.join(temp_path, 'sass')
+            shutil.copytree('test', sass_path)
+
+            def counting_compile(*args, **kwargs):
+                compiled.append(kwargs['filename'])
+                return compile(*args, **kwargs)
+            app = SassMiddleware(self.sample_wsgi_app, {
+                __name__: (sass_path, sass_path, '/static')
+            })
+            client = Client(app, Response)
+            sassutils.wsgi.compile = counting_compile
+            r = client.get('/static/c.scss.css')
+            self.assertEqual(200, r.status_code)
+            r = client.get('/static/c.scss.css')
+            self.assertEqual(200, r.status_code)
+            self.assertEqual(1, len(compiled))
+        finally:
+            sassutils.wsgi.compile = compile
+            shutil.rmtree(temp_path)
+
+    def test_wsgi_sass_middleware_modified_while_compiling(self):
+        temp_path = tempfile.mkdtemp()
+        compile = sassutils.wsgi.compile
+        try:
+            sass_path = os.path.join(temp_path, 'sass')
+            shutil.copytree('test', sass_path)
+            a_path = os.path.join(sass_path, 'a.scss')
+
+            def modifying_compile(*args, **kwargs):
+                result = compile(*args, **kwargs)
+                with open(a_path, 'a') as f:
+                    f.write('\nh2 { color: red; }\n')
+                stat = os.stat(a_path)
+                os.utime(a_path, (stat.st_atime, stat.st_mtime + 10))
+                return result
+            app = SassMiddleware(self.sample_wsgi_app, {
+                __name__: (sass_path, sass_path, '/static')
+            })
+            client = Client(app, Response)
+            sassutils.wsgi.compile = modifying_compile
+            r = client.get('/static/c.scss.css')
+            sassutils.wsgi.compile = compile
+            self.assertEqual(200, r.status_code)
+            assert b'h2 {' not in r.data
+            r = client.get('/static/c.scss.css',
+                           headers={'If-None-Match': r.headers['ETag']})
+            self.assertEqual(200, r.status_code)
+            assert b'h2 {' in r.data
+        finally:
+            sassutils.wsgi.compile = compile
+            shutil.rmtree(temp_path)
+
 
 class SasscTestCase(unittest.TestCase):
 
@@ -442,6 +901,7 @@ class SasscTestCase(unittest.TestCase):
 test_cases = [
     SassTestCase,
     CompileTestCase,
+    CompileManyTestCase,
     BuilderTestCase,
     ManifestTestCase,
     WsgiTestCase,
@@ -5,15 +5,18 @@
 from __future__ import with_statement
 
 import collections
+import hashlib
+import json
 import os
 import os.path
 import re
 
 from six import string_types
 
-from sass import compile
+from sass import compile, compile_many
 
-__all__ = 'SUFFIXES', 'SUFFIX_PATTERN', 'Manifest', 'build_directory'
+__all__ = ('SUFFIXES', 'SUFFIX_PATTERN', 'STATE_FILENAME', 'Manifest',
+           'build_directory')
 
 
 #: (:class:`collections.Set`) The set of supported filename suffixes.
@@ -23,45 +26,161 @@ SUFFIXES = frozenset(['sass', 'scss'])
 #: filenames of supported :const:`SUFFIXES`.
 SUFFIX_PATTERN = re.compile('[.](' + '|'.join(map(re.escape, SUFFIXES)) + ')$')
 
+#: (:class:`str`) The filename of the build state file that
+#: :func:`build_directory()` stores in the CSS directory to find out
+#: which files have to be compiled again.
+#:
+#: .. versionadded:: 0.5.1
+STATE_FILENAME = '.sass-build-state.json'
 
-def build_directory(sass_path, css_path, _root_sass=None, _root_css=None):
-    """Compiles all SASS/SCSS files in ``path`` to CSS.
+#: (:class:`int`) The format version of the build state file.
+STATE_VERSION = 1
+
+
+def build_directory(sass_path, css_path, force=False, workers=None):
+    """Compiles all SASS/SCSS files in ``path`` to CSS.  Partials, files
+    whose names start with an underscore (e.g. :file:`_mixins.scss`), are
+    not compiled by themselves but only as they are ``@import``\ ed.
+
+    It builds incrementally: the import graph and content hashes of
+    the inputs of each compiled CSS file are recorded in a build state
+    file (:const:`STATE_FILENAME` in ``css_path``), and only files whose
+    inputs have changed since the last build are compiled again,
+    in parallel.
 
     :param sass_path: the path of the directory which contains source files
                       to compile
     :type sass_path: :class:`str`, :class:`basestring`
     :param css_path: the path of the directory compiled CSS files will go
     :type css_path: :class:`str`, :class:`basestring`
+    :param force: compile all files even if they are up to date.
+                  :const:`False` by default
+    :type force: :class:`bool`
+    :param workers: an optional number of threads to compile files in
+                    parallel.  the number of CPUs by default
+    :type workers: :class:`int`
     :returns: a dictionary of source filenames to compiled CSS filenames
     :rtype: :class:`collections.Mapping`
 
+    .. versionadded:: 0.5.1
+       Builds incrementally, and added ``force`` and ``workers``
+       parameters.
+
     """
-    if _root_sass is None or _root_css is None:
-        _root_sass = sass_path
-        _root_css = css_path
-    result = {}
-    if not os.path.isdir(css_path):
-        os.mkdir(css_path)
-    for name in os.listdir(sass_path):
-        if not SUFFIX_PATTERN.search(name):
+    sources = {}
+    partials = []
+    for dirpath, _, filenames in os.walk(sass_path, followlinks=True):
+        for name in filenames:
+            if not SUFFIX_PATTERN.search(name):
+                continue
+            sass_filename = os.path.relpath(os.path.join(dirpath, name),
+                                            sass_path)
+            if name.startswith('_'):
+                partials.append(sass_filename)
+            else:
+                sources[sass_filename] = sass_filename + '.css'
+    state_filename = os.path.join(css_path, STATE_FILENAME)
+    state = {} if force else _load_state(state_filename)
+    digests = {}
+
+    def fullname(filename):
+        return os.path.normpath(os.path.join(sass_path, filename))
+
+    def digest(filename):
+        filename = fullname(filename)
+        try:
+            return digests[filename]
+        except KeyError:
+            try:
+                with open(filename, 'rb') as f:
+                    digests[filename] = hashlib.sha1(f.read()).hexdigest()
+            except (IOError, OSError):
+                digests[filename] = None
+            return digests[filename]
+
+    def is_fresh(sass_filename):
+        try:
+            inputs = state[sass_filename]
+        except KeyError:
+            return False
+        css_fullname = os.path.join(css_path, sources[sass_filename])
+        return os.path.isfile(css_fullname) and all(
+            digest(filename) == hash_ for filename, hash_ in inputs.items()
+        )
+
+    stale = sorted(f for f in sources if not is_fresh(f))
+    # files have to be hashed before they're compiled; a file modified
+    # during the compile would be recorded as fresh otherwise
+    if stale:
+        for filename in partials:
+            digest(filename)
+        for sass_filename in stale:
+            digest(sass_filename)
+            for filename in state.get(sass_filename, ()):
+                digest(filename)
+    results = compile_many(
+        filename=[os.path.join(sass_path, f) for f in stale],
+        include_paths=[sass_path],
+        workers=workers,
+        return_graph=True
+    )
+    state = dict((f, state[f]) for f in sources if f in state)
+    error = None
+    for sass_filename, result in zip(stale, results):
+        state.pop(sass_filename, None)
+        if isinstance(result, Exception):
+            error = error or result
             continue
-        sass_fullname = os.path.join(sass_path, name)
-        if os.path.isfile(sass_fullname):
-            css_fullname = os.path.join(css_path, name) + '.css'
-            css = compile(filename=sass_fullname, include_paths=[_root_sass])
-            with open(css_fullname, 'w') as css_file:
-                try:
-                    css_file.write(css)
-                except UnicodeEncodeError:
-                    css_file.write(css.encode('utf-8'))
-            result[os.path.relpath(sass_fullname, _root_sass)] = \
-                os.path.relpath(css_fullname, _root_css)
-        elif os.path.isdir(sass_fullname):
-            css_fullname = os.path.join(css_path, name)
-            subresult = build_directory(sass_fullname, css_fullname,
-                                        _root_sass, _root_css)
-            result.update(subresult)
-    return result
+        css, graph = result
+        css_fullname = os.path.join(css_path, sources[sass_filename])
+        css_folder = os.path.dirname(css_fullname)
+        if not os.path.isdir(css_folder):
+            os.makedirs(css_folder)
+        with open(css_fullname, 'w') as css_file:
+            try:
+                css_file.write(css)
+            except UnicodeEncodeError:
+                css_file.write(css.encode('utf-8'))
+        # an input which wasn't hashed beforehand is recorded without
+        # a hash, so that it's compiled again next time
+        inputs = (os.path.relpath(entry.path, sass_path) for entry in graph)
+        state[sass_filename] = dict(
+            (f, digests.get(fullname(f))) for f in inputs
+        )
+    _save_state(state_filename, state)
+    if error is not None:
+        raise error
+    return sources
+
+
+def _load_state(filename):
+    """Loads the build state file :func:`build_directory()` made.
+    It returns an empty state if the file doesn't exist or is broken.
+
+    """
+    try:
+        with open(filename) as f:
+            state = json.load(f)
+    except (IOError, OSError, ValueError):
+        return {}
+    if not isinstance(state, dict) or \
+       state.get('version') != STATE_VERSION or \
+       not isinstance(state.get('inputs'), dict):
+        return {}
+    return state['inputs']
+
+
+def _save_state(filename, inputs):
+    """Saves the build state, a dictionary of source filenames to
+    the content hashes of their inputs, to the file of ``filename``.
+
+    """
+    folder = os.path.dirname(filename)
+    if folder and not os.path.isdir(folder):
+        os.makedirs(folder)
+    with open(filename, 'w') as f:
+        json.dump({'version': STATE_VERSION, 'inputs': inputs}, f,
+                  indent=1, sort_keys=True)
 
 
 class Manifest(object):
@@ -140,20 +259,28 @@ class Manifest(object):
         css_path = os.path.join(package_dir, self.css_path, css_filename)
         return sass_path, css_path
 
-    def build(self, package_dir):
+    def build(self, package_dir, force=False):
         """Builds the SASS/SCSS files in the specified :attr:`sass_path`.
         It finds :attr:`sass_path` and locates :attr:`css_path`
-        as relative to the given ``package_dir``.
+        as relative to the given ``package_dir``.  Files that are
+        up to date are not compiled again unless ``force`` is set.
+        See also :func:`build_directory()`.
 
         :param package_dir: the path of package directory
         :type package_dir: :class:`str`, :class:`basestring`
+        :param force: compile all files even if they are up to date.
+                      :const:`False` by default
+        :type force: :class:`bool`
         :returns: the set of compiled CSS filenames
         :rtype: :class:`collections.Set`
 
+        .. versionadded:: 0.5.1
+           Added optional ``force`` parameter.
+
         """
         sass_path = os.path.join(package_dir, self.sass_path)
         css_path = os.path.join(package_dir, self.css_path)
-        css_files = build_directory(sass_path, css_path).values()
+        css_files = build_directory(sass_path, css_path, force=force).values()
         return frozenset(os.path.join(self.css_path, filename)
                          for filename in css_files)
 
@@ -85,12 +85,18 @@ class build_sass(Command):
     """Builds SASS/SCSS files to CSS files."""
 
     descriptin = __doc__
-    user_options = []
+    user_options = [
+        ('force', 'f',
+         'compile all SASS/SCSS files even if they are up to date')
+    ]
+    boolean_options = ['force']
 
     def initialize_options(self):
         self.package_dir = None
+        self.force = None
 
     def finalize_options(self):
+        self.force = bool(self.force)
         self.package_dir = {}
         if self.distribution.package_dir:
             self.package_dir = {}
@@ -106,7 +112,7 @@ class build_sass(Command):
         for package_name, manifest in manifests.items():
             package_dir = self.get_package_dir(package_name)
             distutils.log.info("building '%s' sass", package_name)
-            css_files = manifest.build(package_dir)
+            css_files = manifest.build(package_dir, force=self.force)
             map(distutils.log.info, css_files)
             package_data.setdefault(package_name, []).extend(css_files)
             data_files.extend((package_dir, f) for f in css_files)
@@ -5,15 +5,28 @@
 from __future__ import absolute_import, with_statement
 
 import collections
+import email.utils
+import hashlib
 import os
 import os.path
+import time
 
 from pkg_resources import resource_filename
 
-from sass import CompileError
+from sass import CompileError, compile
 from .builder import Manifest
 
-__all__ = 'SassMiddleware',
+__all__ = 'CacheEntry', 'SassMiddleware'
+
+
+#: (:class:`type`) A compiled stylesheet :class:`SassMiddleware` keeps
+#: in memory.  ``css`` and ``source_map`` are encoded bytes, and ``mtimes``
+#: maps every file of its import graph to the modification time it had
+#: before compiled (:const:`None` if it may have been modified while
+#: compiling).
+CacheEntry = collections.namedtuple(
+    'CacheEntry', 'css source_map mtimes etag last_modified'
+)
 
 
 class SassMiddleware(object):
@@ -21,6 +34,12 @@ class SassMiddleware(object):
     requested it finds a matched SASS/SCSS source file and then compiled
     it into CSS.
 
+    Compiled CSS and source maps are kept in memory, and a stylesheet is
+    compiled again only when any file of its import graph has been
+    modified since.  Responses have :mailheader:`ETag` and
+    :mailheader:`Last-Modified` headers so that browsers can revalidate
+    them with ``304 Not Modified``.
+
     :param app: the WSGI application to wrap
     :type app: :class:`collections.Callable`
     :param manifests: build settings.  the same format to
@@ -36,6 +55,10 @@ class SassMiddleware(object):
        It creates also source map files with filenames followed by
        :file:`.map` suffix.
 
+    .. versionchanged:: 0.5.1
+       It doesn't write compiled files to the disk anymore, but caches
+       them in memory and serves source maps as well.
+
     """
 
     def __init__(self, app, manifests, package_dir={},
@@ -55,6 +78,7 @@ class SassMiddleware(object):
                 continue
             path = resource_filename(package_name, '')
             self.package_dir[package_name] = path
+        self.cache = {}
         self.paths = []
         for package_name, manifest in self.manifests.items():
             wsgi_path = manifest.wsgi_path
@@ -67,38 +91,142 @@ class SassMiddleware(object):
 
     def __call__(self, environ, start_response):
         path = environ.get('PATH_INFO', '/')
-        if path.endswith('.css'):
+        if path.endswith('.css') or path.endswith('.css.map'):
+            source_map = path.endswith('.map')
             for prefix, package_dir, manifest in self.paths:
                 if not path.startswith(prefix):
                     continue
                 css_filename = path[len(prefix):]
+                if source_map:
+                    css_filename = css_filename[:-4]
                 sass_filename = css_filename[:-4]
                 try:
-                    result = manifest.build_one(package_dir,
-                                                sass_filename,
-                                                source_map=True)
+                    entry = self.get_compiled(package_dir, manifest,
+                                              sass_filename)
                 except (IOError, OSError):
                     break
                 except CompileError as e:
                     start_response(self.error_status,
                                    [('Content-Type', 'text/css')])
                     return [
-                        '/*\n', str(e), '\n*/\n\n',
-                        'body:before { content: ',
-                        self.quote_css_string(str(e)),
-                        '; color: maroon; background-color: white; }'
+                        b'/*\n', str(e).encode('utf-8'), b'\n*/\n\n',
+                        b'body:before { content: ',
+                        self.quote_css_string(str(e)).encode('utf-8'),
+                        b'; color: maroon; background-color: white; }'
                     ]
-                out = start_response('200 OK', [('Content-Type', 'text/css')])
-                with open(os.path.join(package_dir, result), 'r') as in_:
-                    while 1:
-                        chunk = in_.read(4096)
-                        if chunk:
-                            out(chunk)
-                        else:
-                            break
-                return ()
+                headers = [
+                    ('ETag', entry.etag),
+                    ('Last-Modified', entry.last_modified)
+                ]
+                if self.is_not_modified(environ, entry):
+                    start_response('304 Not Modified', headers)
+                    return []
+                if source_map:
+                    body = entry.source_map
+                    headers.append(('Content-Type', 'application/json'))
+                else:
+                    body = entry.css
+                    headers.append(('Content-Type', 'text/css'))
+                headers.append(('Content-Length', str(len(body))))
+                start_response('200 OK', headers)
+                return [body]
         return self.app(environ, start_response)
 
+    def get_compiled(self, package_dir, manifest, filename):
+        """Gets the compiled :class:`CacheEntry` of the given SASS/SCSS
+        ``filename`` from the cache, or compiles it if it's not cached yet
+        or any file of its import graph has been modified.
+
+        :param package_dir: the path of package directory
+        :type package_dir: :class:`str`, :class:`basestring`
+        :param manifest: the manifest the file belongs to
+        :type manifest: :class:`~sassutils.builder.Manifest`
+        :param filename: the filename of SASS/SCSS source to compile
+        :type filename: :class:`str`, :class:`basestring`
+        :returns: the compiled stylesheet
+        :rtype: :class:`CacheEntry`
+        :raises sass.CompileError: when it fails to compile
+        :raises exceptions.IOError: when the file doesn't exist
+
+        .. versionadded:: 0.5.1
+
+        """
+        sass_filename, css_filename = manifest.resolve_filename(
+            package_dir, filename)
+        entry = self.cache.get(sass_filename)
+        # files are stat()ed before they're compiled; a file modified
+        # during the compile would be cached as fresh otherwise
+        mtimes = {}
+        for f in [sass_filename] + list(entry.mtimes if entry else ()):
+            try:
+                mtimes[os.path.abspath(f)] = os.stat(f).st_mtime
+            except (IOError, OSError):
+                pass
+        if entry is not None and all(
+            mtime is not None and mtimes.get(os.path.abspath(f)) == mtime
+            for f, mtime in entry.mtimes.items()
+        ):
+            return entry
+        started = time.time()
+        css, source_map, graph = compile(
+            filename=sass_filename,
+            include_paths=[os.path.join(package_dir, manifest.sass_path)],
+            source_comments='map',
+            source_map_filename=css_filename + '.map',
+            return_graph=True
+        )
+        css = css.encode('utf-8')
+        # files found only by the compile (e.g. imported partials on the
+        # first request) are stat()ed now; unless they're older than the
+        # compile they may have changed during it, and are recorded
+        # without a modification time so that they're compiled again
+        for e in graph:
+            path = os.path.abspath(e.path)
+            if path in mtimes:
+                continue
+            try:
+                mtime = os.stat(e.path).st_mtime
+            except (IOError, OSError):
+                mtime = None
+            if mtime is not None and mtime >= started:
+                mtime = None
+            mtimes[path] = mtime
+        mtimes = dict((e.path, mtimes[os.path.abspath(e.path)])
+                      for e in graph)
+        known_mtimes = [mtime for mtime in mtimes.values()
+                        if mtime is not None]
+        entry = CacheEntry(
+            css=css,
+            source_map=source_map.encode('utf-8'),
+            mtimes=mtimes,
+            etag='"' + hashlib.sha1(css).hexdigest() + '"',
+            last_modified=email.utils.formatdate(
+                max(known_mtimes) if known_mtimes else started,
+                usegmt=True
+            )
+        )
+        self.cache[sass_filename] = entry
+        return entry
+
+    @staticmethod
+    def is_not_modified(environ, entry):
+        """Whether the conditional request of ``environ`` can be answered
+        with ``304 Not Modified`` for the given :class:`CacheEntry`.
+
+        """
+        if_none_match = environ.get('HTTP_IF_NONE_MATCH')
+        if if_none_match is not None:
+            etags = [tag.strip() for tag in if_none_match.split(',')]
+            return entry.etag in etags or '*' in etags
+        if_modified_since = environ.get('HTTP_IF_MODIFIED_SINCE')
+        if if_modified_since is not None:
+            since = email.utils.parsedate_tz(if_modified_since)
+            last_modified = email.utils.parsedate_tz(entry.last_modified)
+            return since is not None and \
+                email.utils.mktime_tz(since) >= \
+                email.utils.mktime_tz(last_modified)
+        return False
+
     @staticmethod
     def quote_css_string(s):
         """Quotes a string as CSS string literal."""
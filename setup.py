@@ -88,7 +88,7 @@ else:
         flags.append(
             '-Wno-error=unused-command-line-argument-hard-error-in-future'
         )
-    link_flags = ['-fPIC', '-lstdc++']
+    link_flags = ['-fPIC', '-lstdc++', '-lpthread']
 
 sass_extension = Extension(
     '_sass',
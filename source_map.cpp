@@ -37,10 +37,10 @@ namespace Sass {
     size_t previous_original_column = 0;
     size_t previous_original_file = 0;
     for (size_t i = 0; i < mappings.size(); ++i) {
-      const size_t generated_line = mappings[i].generated_position.line - 1;
-      const size_t generated_column = mappings[i].generated_position.column - 1;
-      const size_t original_line = mappings[i].original_position.line - 1;
-      const size_t original_column = mappings[i].original_position.column - 1;
+      const size_t generated_line = mappings[i].generated_position.line() - 1;
+      const size_t generated_column = mappings[i].generated_position.column() - 1;
+      const size_t original_line = mappings[i].original_position.line() - 1;
+      const size_t original_column = mappings[i].original_position.column() - 1;
       const size_t original_file = mappings[i].original_position.file - 1;
 
       if (generated_line != previous_generated_line) {
@@ -73,18 +73,18 @@ namespace Sass {
 
   void SourceMap::remove_line()
   {
-    current_position.line -= 1;
-    current_position.column = 1;
+    current_position = Position(current_position.line() - 1, 1);
   }
 
   void SourceMap::update_column(const string& str)
   {
     const int new_line_count = std::count(str.begin(), str.end(), '\n');
-    current_position.line += new_line_count;
     if (new_line_count >= 1) {
-      current_position.column = str.size() - str.find_last_of('\n');
+      current_position = Position(current_position.line() + new_line_count,
+                                  str.size() - str.find_last_of('\n'));
     } else {
-      current_position.column += str.size();
+      current_position = Position(current_position.line(),
+                                  current_position.column() + str.size());
     }
   }
 
@@ -0,0 +1,47 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "../prelexer.hpp"
+
+using namespace std;
+using namespace Sass;
+
+typedef const char* (*prelexer)(const char*);
+
+// random strings over the characters that matter to the token matchers
+string random_source()
+{
+  static const char chars[] = "-_\\.+#09afAFzZ%$@ \n\"'()\xc3\xa9";
+  string src;
+  for (int i = rand() % 12; i > 0; --i) src += chars[rand() % (sizeof(chars) - 1)];
+  return src;
+}
+
+int check(const char* name, prelexer fast, prelexer reference)
+{
+  int failures = 0;
+  for (int i = 0; i < 200000; ++i) {
+    string src(random_source());
+    const char* expected = reference(src.c_str());
+    const char* actual = fast(src.c_str());
+    if (expected != actual && failures++ < 5) {
+      cout << name << "(\"" << src << "\"): expected "
+           << (expected ? expected - src.c_str() : -1) << ", got "
+           << (actual ? actual - src.c_str() : -1) << endl;
+    }
+  }
+  cout << name << ": " << (failures ? "FAILED" : "ok") << endl;
+  return failures;
+}
+
+int main()
+{
+  srand(42);
+  int failures = 0;
+  failures += check("identifier", Prelexer::identifier, Prelexer::Reference::identifier);
+  failures += check("name", Prelexer::name, Prelexer::Reference::name);
+  failures += check("unsigned_number", Prelexer::unsigned_number, Prelexer::Reference::unsigned_number);
+  failures += check("number", Prelexer::number, Prelexer::Reference::number);
+  failures += check("hex", Prelexer::hex, Prelexer::Reference::hex);
+  return failures ? 1 : 0;
+}
@@ -26,7 +26,7 @@ namespace Sass {
     operator bool()   { return begin && end && begin >= end; }
     operator string() { return to_string(); }
 
-    bool operator==(Token t)  { return to_string() == t.to_string(); }
+    bool operator==(Token t)  { return length() == t.length() && !memcmp(begin, t.begin, length()); }
   };
 
 }